@@ -1,234 +1,244 @@
 #include "data/PicUncompress.h"
-#include <TFT_eSPI.h>
-#include <Arduino.h>
-#include <math.h>
 #include <cstring>
 
-
-extern TFT_eSPI tft;  // ← これを追加
-
-std::vector<uint8_t> output;
-int cur_bit;
-int cur_byte;
-
 // ------------------------- ビット読み出し -------------------------
-uint8_t read_bit(const std::vector<uint8_t>& data) {
-  if (cur_bit == -1) {
-    cur_byte++;
-    cur_bit = 7;
+// 未読が 32 ビットを切ったら 4 バイトまとめて補充する（入力末尾付近だけ1バイトずつ）
+void PicDecoder::refill() {
+  while (count_ <= 32) {
+    size_t inWin = pos_ - winStart_;
+    if (inWin + 4 <= winLen_) {
+      const uint8_t* p = win_ + inWin;
+      uint32_t w = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+      bits_ |= uint64_t(w) << (32 - count_);
+      pos_ += 4;
+      count_ += 32;
+    } else if (inWin < winLen_) {
+      bits_ |= uint64_t(win_[inWin]) << (56 - count_);
+      pos_++;
+      count_ += 8;
+    } else if (pos_ < len_ && fetchWindow()) {
+      continue;
+    } else {
+      pos_++;  // 末尾を越えた分は 0
+      count_ += 8;
+    }
   }
-  return (data[cur_byte] >> cur_bit--) & 1;
 }
 
-int read_int(const std::vector<uint8_t>& data, int count) {
-  int n = 0;
-  while (count--) {
-    n = (n << 1) | read_bit(data);
-  }
-  return n;
+// 次の最大 WINDOW_SIZE バイトを読む（短くてもよい）。1 バイトも読めなければそこが入力の終端
+bool PicDecoder::fetchWindow() {
+  if (!fetch_) return false;
+  size_t got = fetch_(static_cast<uint32_t>(pos_), scratch_.window, WINDOW_SIZE, fetchCtx_);
+  if (got > WINDOW_SIZE) got = WINDOW_SIZE;
+  win_ = scratch_.window;
+  winStart_ = pos_;
+  winLen_ = got;
+  if (got == 0) len_ = pos_;
+  return got > 0;
 }
 
-// ------------------------- タイル転置 -------------------------
-void transpose_tiles(std::vector<uint8_t>& data, int width) {
-  int size = width * width;
-  for (int i = 0; i < size; i++) {
-    int j = (i * width + i / width) % size;
-    if (i < j) {
-      uint8_t tmp[16];
-      uint8_t* p = &data[i * 16];
-      uint8_t* q = &data[j * 16];
-      memcpy(tmp, p, 16);
-      memcpy(p, q, 16);
-      memcpy(q, tmp, 16);
-    }
-  }
+uint32_t PicDecoder::readBits(int count) {
+  if (count_ < count) refill();
+  uint32_t v = static_cast<uint32_t>(bits_ >> (64 - count));
+  bits_ <<= count;
+  count_ -= count;
+  return v;
+}
+
+// RLE の長さプレフィックス: 先頭の 1 の数を CLZ で数える（16 以上はエラーとして 16 を返す）
+int PicDecoder::readOnes() {
+  if (count_ < 17) refill();
+  // 見るのは上位 17 ビットまで（count_ >= 17）なので 32 ビットの clz で足りる（Xtensa の NSAU 1 命令）
+  uint32_t inv = ~static_cast<uint32_t>(bits_ >> 32);
+  int n = inv ? __builtin_clz(inv) : 32;
+  if (n >= 16) return 16;
+  bits_ <<= n + 1;
+  count_ -= n + 1;
+  return n;
 }
 
 // ------------------------- plane展開 -------------------------
-std::vector<uint8_t> fill_plane(const std::vector<uint8_t>& data, int width) {
-  static int table[16] = {
+// RLE / データパケットを読みながら、2bit グループを最終位置に直接書き込む。
+// ストリーム上の位置は (行 r, 列 x)。r は 2bit 単位の行（W*4 行）、x はバイト列（W*8 列）で、
+// グループは plane[(r/4)*W*8 + x] の (6 - 2*(r%4)) ビット目に入る。
+// plane はゼロクリアしておくので、0 のランは位置を進めるだけでよい。
+// emitColumns なら、読み終えたタイル列（r/4 より左）をその都度仕上げる
+bool PicDecoder::fillPlane(uint8_t* plane, int width, bool emitColumns) {
+  static const int table[16] = {
     0x0001,0x0003,0x0007,0x000F,0x001F,0x003F,0x007F,0x00FF,
     0x01FF,0x03FF,0x07FF,0x0FFF,0x1FFF,0x3FFF,0x7FFF,0xFFFF
   };
-  int mode = read_bit(data);
-  int size = width * width * 0x20;
-  std::vector<uint8_t> plane(size);
-  int len = 0;
-
-  while (len < size) {
+  const int rowBytes = width * 8;
+  const int rows = width * 4;
+  memset(plane, 0, width * rowBytes);
+
+  int mode = readBit();
+  int r = 0;
+  int x = 0;
+  while (r < rows) {
     if (mode) {
-      while (len < size) {
-        int bit_group = read_int(data, 2);
+      uint8_t* dst = plane + (r >> 2) * rowBytes;
+      int shift = 6 - 2 * (r & 3);
+      while (true) {
+        int bit_group = readBits(2);
         if (!bit_group) break;
-        plane[len++] = bit_group;
+        dst[x] |= bit_group << shift;
+        if (++x == rowBytes) {
+          x = 0;
+          if (++r == rows) break;
+          dst = plane + (r >> 2) * rowBytes;
+          shift = 6 - 2 * (r & 3);
+        }
       }
     } else {
-      size_t w = 0;
-      while (read_bit(data)) w++;
-      if (w >= 16) return {}; // エラー
-      int n = table[w] + read_int(data, w + 1);
-      while (len < size && n--) plane[len++] = 0;
+      int w = readOnes();
+      if (w >= 16) return false;  // エラー
+      int pos = r * rowBytes + x + table[w] + readBits(w + 1);
+      if (pos >= rows * rowBytes) {
+        r = rows;
+      } else {
+        r = pos / rowBytes;
+        x = pos % rowBytes;
+      }
     }
+    if (overrun()) return false;
+    if (emitColumns) finishColumns(r >> 2);
     mode ^= 1;
   }
+  return true;
+}
 
-  std::vector<uint8_t> ram(size);
-  len = 0;
-  for (int y = 0; y < width; y++) {
-    for (int x = 0; x < width * 8; x++) {
-      for (int i = 0; i < 4; i++) {
-        ram[len++] = plane[(y * 4 + i) * width * 8 + x];
-      }
+// ------------------------- Grayコード復号 -------------------------
+namespace {
+const int codes[2][16] = {
+  {0x0,0x1,0x3,0x2,0x7,0x6,0x4,0x5,0xF,0xE,0xC,0xD,0x8,0x9,0xB,0xA},
+  {0xF,0xE,0xC,0xD,0x8,0x9,0xB,0xA,0x0,0x1,0x3,0x2,0x7,0x6,0x4,0x5}
+};
+
+// 1バイト（上位 nybble → 下位 nybble の順）を codes で復号する。bit は直前の出力の最下位ビット
+uint8_t decodeDeltaByte(int bit, uint8_t in) {
+  int code_hi = codes[bit][in >> 4];
+  int code_lo = codes[code_hi & 1][in & 0xF];
+  return (code_hi << 4) | code_lo;
+}
+
+// [carry][入力バイト] → 復号後のバイト。次の carry は復号後のバイトの最下位ビット
+struct DeltaTable {
+  uint8_t out[2][256];
+  DeltaTable() {
+    for (int bit = 0; bit < 2; bit++) {
+      for (int b = 0; b < 256; b++) out[bit][b] = decodeDeltaByte(bit, b);
     }
   }
+};
 
-  for (int i = 0; i < size - 3; i += 4) {
-    ram[i / 4] = (ram[i] << 6) | (ram[i + 1] << 4) | (ram[i + 2] << 2) | ram[i + 3];
+const DeltaTable& deltaTable() {
+  static const DeltaTable table;  // 初回使用時に作る（約 512 バイト）
+  return table;
+}
+}  // namespace
+
+// タイル列を上から下へ、1バイト1回の表引きで復号する。
+// デルタは行方向（左の列から右の列へ）に続くので、carry は行ごとに持ち越す
+void PicDecoder::deltaColumn(uint8_t* column, uint8_t* carry, int height) {
+  const DeltaTable &table = deltaTable();
+  for (int r = 0; r < height; r++) {
+    uint8_t v = table.out[carry[r]][column[r]];
+    column[r] = v;
+    carry[r] = v & 1;
   }
-
-  ram.resize(size / 4);
-  return ram;
 }
 
-// ------------------------- Grayコード復号 -------------------------
-void uncompress_plane(std::vector<uint8_t>& plane, int width) {
-  static int codes[2][16] = {
-    {0x0,0x1,0x3,0x2,0x7,0x6,0x4,0x5,0xF,0xE,0xC,0xD,0x8,0x9,0xB,0xA},
-    {0xF,0xE,0xC,0xD,0x8,0x9,0xB,0xA,0x0,0x1,0x3,0x2,0x7,0x6,0x4,0x5}
-  };
-  for (int x = 0; x < width * 8; x++) {
-    int bit = 0;
-    for (int y = 0; y < width; y++) {
-      int i = y * width * 8 + x;
-      int nybble_hi = (plane[i] >> 4) & 0xF;
-      int code_hi = codes[bit][nybble_hi];
-      bit = code_hi & 1;
-      int nybble_lo = plane[i] & 0xF;
-      int code_lo = codes[bit][nybble_lo];
-      bit = code_lo & 1;
-      plane[i] = (code_hi << 4) | code_lo;
-    }
+// モード 1, 2 の合成: dst ^= src を 4 バイトずつ行う
+void PicDecoder::xorColumn(uint8_t* dst, const uint8_t* src, size_t size) {
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    uint32_t a, b;
+    memcpy(&a, dst + i, 4);
+    memcpy(&b, src + i, 4);
+    a ^= b;
+    memcpy(dst + i, &a, 4);
   }
+  for (; i < size; i++) dst[i] ^= src[i];
 }
 
-// ------------------------- uncompress -------------------------
-int uncompress(const std::vector<uint8_t>& data) {
-  cur_bit = 7;
-  cur_byte = 0;
-  int width = read_int(data, 4);
-  if (read_int(data, 4) != width) return -1;
+// ------------------------- タイル列の仕上げ -------------------------
+void PicDecoder::finishColumns(int upTo) {
+  while (finished_ < upTo) finishColumn(finished_++);
+}
 
-  int size = width * width * 8;
-  std::vector<uint8_t> rams[2];
-  output.resize(size * 2);
+void PicDecoder::finishColumn(int tc) {
+  const int height = width_ * 8;
+  uint8_t* first = scratch_.planes[order_] + tc * height;
+  uint8_t* second = scratch_.planes[order_ ^ 1] + tc * height;
+
+  deltaColumn(first, carry_[0], height);
+  if (mode_ != 1) deltaColumn(second, carry_[1], height);
+  if (mode_ != 0) xorColumn(second, first, height);
+
+  // プレーンの列 tc（行 r = tc*H + r）をスキャンライン順の出力に置く
+  const uint8_t* lo = scratch_.planes[0] + tc * height;
+  const uint8_t* hi = scratch_.planes[1] + tc * height;
+  uint8_t* o = out_ + tc * 2;
+  for (int r = 0; r < height; r++) {
+    o[0] = lo[r];
+    o[1] = hi[r];
+    o += width_ * 2;
+  }
+  if (onColumn_) onColumn_(tc, width_, out_, ctx_);
+}
 
-  int order = read_bit(data);
-  rams[order] = fill_plane(data, width);
+// ------------------------- decode -------------------------
+int PicDecoder::decode(const uint8_t* data, size_t len, uint8_t* out, size_t outCap,
+                       ColumnCallback onColumn, void* ctx) {
+  win_ = data;
+  winStart_ = 0;
+  winLen_ = len;
+  len_ = len;
+  fetch_ = nullptr;
+  fetchCtx_ = nullptr;
+  return run(out, outCap, onColumn, ctx);
+}
 
-  int mode = read_bit(data);
-  if (mode) mode += read_bit(data);
+int PicDecoder::decode(InputFetch fetch, void* fetchCtx, uint8_t* out, size_t outCap,
+                       ColumnCallback onColumn, void* ctx) {
+  win_ = scratch_.window;
+  winStart_ = 0;
+  winLen_ = 0;
+  len_ = SIZE_MAX;
+  fetch_ = fetch;
+  fetchCtx_ = fetchCtx;
+  return run(out, outCap, onColumn, ctx);
+}
 
-  rams[order ^ 1] = fill_plane(data, width);
+int PicDecoder::run(uint8_t* out, size_t outCap, ColumnCallback onColumn, void* ctx) {
+  pos_ = 0;
+  bits_ = 0;
+  count_ = 0;
+  width_ = 0;
 
-  uncompress_plane(rams[order], width);
-  if (mode != 1) uncompress_plane(rams[order ^ 1], width);
+  int width = readBits(4);
+  if (readBits(4) != static_cast<uint32_t>(width)) return -1;
+  if (width < 1 || width > MAX_TILES) return -1;
 
-  if (mode != 0) {
-    for (int i = 0; i < size; i++) {
-      rams[order ^ 1][i] ^= rams[order][i];
-    }
-  }
+  int size = width * width * 8;
+  if (outCap < static_cast<size_t>(size) * 2) return -1;
 
-  for (int i = 0; i < size; i++) {
-    output[i * 2]     = rams[0][i];
-    output[i * 2 + 1] = rams[1][i];
-  }
+  width_ = width;
+  out_ = out;
+  onColumn_ = onColumn;
+  ctx_ = ctx;
+  finished_ = 0;
+  memset(carry_, 0, sizeof(carry_));
 
-  transpose_tiles(output, width);
-  return size * 2;
-}
+  order_ = readBit();
+  if (!fillPlane(scratch_.planes[order_], width, false)) return -1;
 
-// ------------------------- 2bpp描画 -------------------------
-void draw2bpp(const std::vector<uint8_t>& data, int width, int height, int scale) {
-  const uint16_t pal[4] = {0xFFFF, 0xAAAA, 0x5555, 0x0000};;
-  int tilesX = width / 8;
-  int tilesY = height / 8;
-  int tileIndex = 0;
-
-  for (int ty = 0; ty < tilesY; ty++) {
-    for (int tx = 0; tx < tilesX; tx++) {
-      const uint8_t* tile = &data[tileIndex * 16];
-      tileIndex++;
-      for (int row = 0; row < 8; row++) {
-        uint8_t lo = tile[row * 2];
-        uint8_t hi = tile[row * 2 + 1];
-        for (int col = 0; col < 8; col++) {
-          int bit = 7 - col;
-          uint8_t idx = ((hi >> bit) & 1) << 1 | ((lo >> bit) & 1);
-          int px = tx * 8 + col;
-          int py = ty * 8 + row;
-          tft.fillRect(px * scale, py * scale, scale, scale, pal[idx]);
-        }
-      }
-    }
-  }
-}
+  mode_ = readBit();
+  if (mode_) mode_ += readBit();
 
-// ------------------------- 2bpp描画 -------------------------
-/*void draw2bpp_color(const std::vector<uint8_t>& data,
-              int width, int height, int scale,
-              const uint16_t* palette) {
-  int tilesX = width / 8;
-  int tilesY = height / 8;
-  int tileIndex = 0;
-
-  for (int ty = 0; ty < tilesY; ty++) {
-    for (int tx = 0; tx < tilesX; tx++) {
-      const uint8_t* tile = &data[tileIndex * 16];
-      tileIndex++;
-      for (int row = 0; row < 8; row++) {
-        uint8_t lo = tile[row * 2];
-        uint8_t hi = tile[row * 2 + 1];
-        for (int col = 0; col < 8; col++) {
-          int bit = 7 - col;
-          uint8_t idx = ((hi >> bit) & 1) << 1 | ((lo >> bit) & 1);
-          int px = tx * 8 + col;
-          int py = ty * 8 + row;
-          tft.fillRect(px * scale, py * scale, scale, scale, palette[idx]);
-        }
-      }
-    }
-  }
-}*/
-
-void draw2bpp_color(const std::vector<uint8_t>& data,
-                    int width, int height, int scale,
-                    const uint16_t* palette,
-                    int x0, int y0) // ← 追加
-{
-    int tilesX = width / 8;
-    int tilesY = height / 8;
-    int tileIndex = 0;
-
-    for (int ty = 0; ty < tilesY; ty++) {
-        for (int tx = 0; tx < tilesX; tx++) {
-            const uint8_t* tile = &data[tileIndex * 16];
-            tileIndex++;
-            for (int row = 0; row < 8; row++) {
-                uint8_t lo = tile[row * 2];
-                uint8_t hi = tile[row * 2 + 1];
-                for (int col = 0; col < 8; col++) {
-                    int bit = 7 - col;
-                    uint8_t idx = ((hi >> bit) & 1) << 1 | ((lo >> bit) & 1);
-
-                    int px = x0 + tx * 8 + col; // ← xオフセット追加
-                    int py = y0 + ty * 8 + row; // ← yオフセット追加
-
-                    tft.fillRect(px * scale, py * scale, scale, scale, palette[idx]);
-                }
-            }
-        }
-    }
+  // 2 枚目のプレーンを読みながら、揃ったタイル列から仕上げる
+  if (!fillPlane(scratch_.planes[order_ ^ 1], width, true)) return -1;
+  finishColumns(width);
+  return size * 2;
 }
-
-
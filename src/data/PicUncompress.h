@@ -1,21 +1,94 @@
 #pragma once
-#include <vector>
 #include <stdint.h>
+#include <stddef.h>
 
 
-// グローバル出力バッファ
-extern std::vector<uint8_t> output;
+/**
+ * @brief ポケモンの圧縮スプライトを 2bpp のスキャンライン順に展開するデコーダ
+ *
+ * 出力は上の行から順に、各行をタイル列ごとに (下位プレーン, 上位プレーン) の
+ * 2 バイトで並べる: 行 r・タイル列 tc の 8 ピクセル = out[(r * W + tc) * 2 + 0/1]。
+ * 1 行は W*2 バイトなので、描画側は行単位でそのままパネルに流せる。
+ *
+ * プレーンはタイル列（8 ピクセル幅）単位で並んでいるので、2 枚目のプレーンの
+ * 各タイル列が読み終わった時点でそのタイル列は確定する。decode() に ColumnCallback を
+ * 渡すと、確定したタイル列から順に（左から）out に書いて通知するので、
+ * 描画側は残りの展開を待たずにその列を送れる。
+ *
+ * ビット読み出し位置などの状態をすべてオブジェクト内に持ち、
+ * 出力先と作業領域（Scratch）は呼び出し側が用意する。展開中にヒープを使わないので、
+ * 別々の PicDecoder / Scratch を使えば複数タスクで同時に展開できる。
+ */
+class PicDecoder {
+public:
+    static constexpr int MAX_TILES = 7;                              // 幅・高さ最大 7 タイル(56px)
+    static constexpr size_t PLANE_MAX = MAX_TILES * MAX_TILES * 8;   // 1bpp プレーン 392 バイト
+    static constexpr size_t OUTPUT_MAX = PLANE_MAX * 2;              // 2bpp 出力 784 バイト
 
+    static constexpr size_t WINDOW_SIZE = 64;                        // InputFetch で読む単位
 
-// 圧縮データを展開する関数
-int uncompress(const std::vector<uint8_t>& data);
+    // 展開用の作業領域（848 バイト）。スタックや静的領域に置いて渡す
+    struct Scratch {
+        uint8_t planes[2][PLANE_MAX];
+        uint8_t window[WINDOW_SIZE];   // InputFetch の読み込み先
+    };
 
-// 出力バッファを TFT に描画する関数
-void draw2bpp(const std::vector<uint8_t>& data, int width, int height, int scale=1);
+    // タイル列 tileColumn（0～width-1）が out に揃ったときに呼ばれる。width はタイル数
+    typedef void (*ColumnCallback)(int tileColumn, int width, const uint8_t* out, void* ctx);
+    // 圧縮データの offset バイト目から最大 len バイトを dst に読む。戻り値は読めたバイト数（0 で終端）
+    typedef size_t (*InputFetch)(uint32_t offset, uint8_t* dst, size_t len, void* ctx);
 
-// 出力バッファを TFT に描画する関数
-//void draw2bpp_color(const std::vector<uint8_t>& data, int width, int height, int scale=1,uint16_t const* palette=nullptr);
-void draw2bpp_color(const std::vector<uint8_t>& data,
-                    int width, int height, int scale,
-                    const uint16_t* palette,
-                    int x0 = 0, int y0 = 0); // ← デフォルト引数はここ
\ No newline at end of file
+    explicit PicDecoder(Scratch &scratch) : scratch_(scratch) {}
+
+    // data(len バイト)を out に展開する。戻り値は出力バイト数、失敗時は -1
+    // 入力の末尾を越えて読もうとした場合も失敗にする（それまでに通知した列は不完全な画像の一部）
+    int decode(const uint8_t* data, size_t len, uint8_t* out, size_t outCap,
+               ColumnCallback onColumn = nullptr, void* ctx = nullptr);
+    // 入力を fetch で WINDOW_SIZE ずつ必要な分だけ読みながら展開する（圧縮長が分からなくてよい）
+    int decode(InputFetch fetch, void* fetchCtx, uint8_t* out, size_t outCap,
+               ColumnCallback onColumn = nullptr, void* ctx = nullptr);
+    // 直前の decode() が実際に使った圧縮データのバイト数
+    size_t consumedBytes() const { return (pos_ * 8 - count_ + 7) / 8; }
+    // 直前に展開したスプライトの幅（タイル数）
+    int width() const { return width_; }
+
+private:
+    // --- ビット読み出し（64bit バッファ、MSB から消費） ---
+    // bits_ の上位 count_ ビットが未読。末尾を越えた分は 0 で埋め、overrun() で判定する
+    // 入力は win_[0..winLen_) がストリーム上の winStart_ バイト目からに当たる
+    void refill();
+    bool fetchWindow();
+    uint32_t readBits(int count);   // 1～32 ビット
+    uint8_t readBit() { return readBits(1); }
+    int readOnes();                 // 連続する 1 の数を数え、終端の 0 まで読み飛ばす
+    bool overrun() const { return pos_ > len_ && (pos_ - len_) * 8 > static_cast<size_t>(count_); }
+    int run(uint8_t* out, size_t outCap, ColumnCallback onColumn, void* ctx);
+    bool fillPlane(uint8_t* plane, int width, bool emitColumns);
+
+    // --- タイル列単位の仕上げ（デルタ復号 → XOR 合成 → 出力） ---
+    void finishColumns(int upTo);
+    void finishColumn(int tc);
+    static void deltaColumn(uint8_t* column, uint8_t* carry, int height);
+    static void xorColumn(uint8_t* dst, const uint8_t* src, size_t size);
+
+    Scratch &scratch_;
+    const uint8_t* win_ = nullptr;
+    size_t winStart_ = 0;
+    size_t winLen_ = 0;
+    size_t len_ = 0;      // 入力の長さ（fetch で終端に達するまでは SIZE_MAX）
+    size_t pos_ = 0;      // 次に bits_ へ積む入力位置（len_ を越えたら 0 を積む）
+    InputFetch fetch_ = nullptr;
+    void* fetchCtx_ = nullptr;
+    uint64_t bits_ = 0;
+    int count_ = 0;
+    int width_ = 0;
+
+    // decode() 中の状態
+    uint8_t* out_ = nullptr;
+    int order_ = 0;       // 先に読むプレーン
+    int mode_ = 0;        // 0: 両方デルタ, 1: XOR のみ, 2: デルタ + XOR
+    int finished_ = 0;    // 仕上げ済みのタイル列数
+    ColumnCallback onColumn_ = nullptr;
+    void* ctx_ = nullptr;
+    uint8_t carry_[2][MAX_TILES * 8];  // デルタ復号の行ごとの carry（左の列から持ち越す）
+};
@@ -1,44 +1,136 @@
 #include "data/SpriteImage.h"
 #include "data/PicUncompress.h"
+#include "data/pokemon_sprite.h"
 #include <Arduino.h>
-
-// 幅・高さテーブル
-struct SizeMap {
-  int size;
-  int width;
-  int height;
-};
-
-SizeMap size_table[] = {
-  {400, 40, 40},
-  {576, 48, 48},
-  {784, 56, 56}
-};
+#include <cstring>
+#include "render/lcd_dma.h"
 
 void displaySpriteImage(const std::vector<uint8_t>compressed) {
-  int out_size = uncompress(compressed);
+  PicDecoder::Scratch scratch;
+  uint8_t output[PicDecoder::OUTPUT_MAX];
+  int out_size = PicDecoder(scratch).decode(compressed.data(), compressed.size(), output, sizeof(output));
   Serial.printf("Uncompressed size=%d bytes\n", out_size);
 
   int width=0, height=0;
-  for (auto& m : size_table) {
-    if (m.size == out_size) { width=m.width; height=m.height; break; }
-  }
-  if (width==0) { Serial.println("Unknown size"); return; }
+  if (!spriteSizeFromOutput(out_size, width, height)) { Serial.println("Unknown size"); return; }
 
   draw2bpp(output, width, height, 2);
 }
 
 void displaySpriteImageColor(const std::vector<uint8_t>compressed, const uint16_t* pal) {
-  int out_size = uncompress(compressed);
+  PicDecoder::Scratch scratch;
+  uint8_t output[PicDecoder::OUTPUT_MAX];
+  int out_size = PicDecoder(scratch).decode(compressed.data(), compressed.size(), output, sizeof(output));
   Serial.printf("Uncompressed size=%d bytes\n", out_size);
 
   int width=0, height=0;
-  for (auto& m : size_table) {
-    if (m.size == out_size) { width=m.width; height=m.height; break; }
-  }
-  if (width==0) { Serial.println("Unknown size"); return; }
+  if (!spriteSizeFromOutput(out_size, width, height)) { Serial.println("Unknown size"); return; }
 
   draw2bpp_color(output, width, height, 2, pal,10,10);
   
 
-}
\ No newline at end of file
+}
+
+// ------------------------- 2bpp描画 -------------------------
+// スキャンライン順の 2bpp のうちタイル列 [firstTile, firstTile + tileCount) を (x, y) に描く。
+// 拡大した行を LcdDma のバッファに入るだけ（同じ行は scale 回）並べて 1 矩形ずつ送るので、
+// 前の矩形を DMA で送っている間に次の矩形を展開できる。パレットは先にバイトスワップしておく
+namespace {
+void blit2bpp(const uint8_t* data, int tilesX, int firstTile, int tileCount, int height,
+              int scale, const uint16_t* palette, int x, int y) {
+  const int lineWidth = tileCount * 8 * scale;
+  if (scale < 1 || lineWidth > (int)LcdDma::BUFFER_PIXELS || !lcdDma.ready()) return;
+  const int rowsPerPush = LcdDma::BUFFER_PIXELS / lineWidth;
+  const int outRows = height * scale;
+
+  uint16_t colors[4];
+  for (int i = 0; i < 4; i++) colors[i] = LcdDma::swap(palette[i]);
+
+  lcdDma.beginBatch();
+  for (int top = 0; top < outRows; top += rowsPerPush) {
+    int rows = outRows - top < rowsPerPush ? outRows - top : rowsPerPush;
+    uint16_t* buf = lcdDma.buffer();
+    for (int i = 0; i < rows; i++) {
+      uint16_t* dst = buf + i * lineWidth;
+      // 拡大で繰り返す行は直前の行をコピーする
+      if ((top + i) % scale != 0 && i > 0) {
+        memcpy(dst, dst - lineWidth, lineWidth * sizeof(uint16_t));
+        continue;
+      }
+      const uint8_t* src = &data[((top + i) / scale * tilesX + firstTile) * 2];
+      for (int tx = 0; tx < tileCount; tx++) {
+        uint8_t lo = src[tx * 2];
+        uint8_t hi = src[tx * 2 + 1];
+        for (int bit = 7; bit >= 0; bit--) {
+          uint16_t c = colors[((hi >> bit) & 1) << 1 | ((lo >> bit) & 1)];
+          for (int s = 0; s < scale; s++) *dst++ = c;
+        }
+      }
+    }
+    lcdDma.push(x, y + top, lineWidth, rows);
+  }
+  lcdDma.endBatch();
+}
+}  // namespace
+
+void draw2bpp(const uint8_t* data, int width, int height, int scale) {
+  const uint16_t pal[4] = {0xFFFF, 0xAAAA, 0x5555, 0x0000};
+  blit2bpp(data, width / 8, 0, width / 8, height, scale, pal, 0, 0);
+}
+
+void draw2bpp(const std::vector<uint8_t>& data, int width, int height, int scale) {
+  draw2bpp(data.data(), width, height, scale);
+}
+
+// ------------------------- 2bpp描画 -------------------------
+/*void draw2bpp_color(const std::vector<uint8_t>& data,
+              int width, int height, int scale,
+              const uint16_t* palette) {
+  int tilesX = width / 8;
+  int tilesY = height / 8;
+  int tileIndex = 0;
+
+  for (int ty = 0; ty < tilesY; ty++) {
+    for (int tx = 0; tx < tilesX; tx++) {
+      const uint8_t* tile = &data[tileIndex * 16];
+      tileIndex++;
+      for (int row = 0; row < 8; row++) {
+        uint8_t lo = tile[row * 2];
+        uint8_t hi = tile[row * 2 + 1];
+        for (int col = 0; col < 8; col++) {
+          int bit = 7 - col;
+          uint8_t idx = ((hi >> bit) & 1) << 1 | ((lo >> bit) & 1);
+          int px = tx * 8 + col;
+          int py = ty * 8 + row;
+          tft.fillRect(px * scale, py * scale, scale, scale, palette[idx]);
+        }
+      }
+    }
+  }
+}*/
+
+void draw2bpp_color(const uint8_t* data,
+                    int width, int height, int scale,
+                    const uint16_t* palette,
+                    int x0, int y0) // ← 追加
+{
+    blit2bpp(data, width / 8, 0, width / 8, height, scale, palette, x0 * scale, y0 * scale);
+}
+
+// 1 タイル列（8 ピクセル幅 x 高さ全体）だけを送る
+void draw2bpp_column(const uint8_t* data,
+                     int width, int height, int tileColumn, int scale,
+                     const uint16_t* palette,
+                     int x0, int y0)
+{
+    blit2bpp(data, width / 8, tileColumn, 1, height, scale, palette,
+             (x0 + tileColumn * 8) * scale, y0 * scale);
+}
+
+void draw2bpp_color(const std::vector<uint8_t>& data,
+                    int width, int height, int scale,
+                    const uint16_t* palette,
+                    int x0, int y0)
+{
+    draw2bpp_color(data.data(), width, height, scale, palette, x0, y0);
+}
@@ -4,3 +4,25 @@
 
 void displaySpriteImage(const std::vector<uint8_t>compressed) ;
 void displaySpriteImageColor(const std::vector<uint8_t>compressed, const uint16_t* pal);
+
+// スキャンライン順の 2bpp（PicDecoder の出力）を TFT に描画する関数
+void draw2bpp(const uint8_t* data, int width, int height, int scale=1);
+void draw2bpp(const std::vector<uint8_t>& data, int width, int height, int scale=1);
+
+// スキャンライン順の 2bpp をパレット付きで描画する関数
+//void draw2bpp_color(const std::vector<uint8_t>& data, int width, int height, int scale=1,uint16_t const* palette=nullptr);
+void draw2bpp_color(const uint8_t* data,
+                    int width, int height, int scale,
+                    const uint16_t* palette,
+                    int x0 = 0, int y0 = 0); // ← デフォルト引数はここ
+void draw2bpp_color(const std::vector<uint8_t>& data,
+                    int width, int height, int scale,
+                    const uint16_t* palette,
+                    int x0 = 0, int y0 = 0);
+
+// スキャンライン順の 2bpp から 1 タイル列（8 ピクセル幅）だけを描画する関数
+// 座標は draw2bpp_color と同じく scale 前の値
+void draw2bpp_column(const uint8_t* data,
+                     int width, int height, int tileColumn, int scale,
+                     const uint16_t* palette,
+                     int x0 = 0, int y0 = 0);
@@ -0,0 +1,10 @@
+#pragma once
+
+// data/ 以下のログ出力。実機では Serial に、ホストのツールでは stderr に出す
+#ifdef ARDUINO
+#include <Arduino.h>
+#define DATA_LOG(...) Serial.printf(__VA_ARGS__)
+#else
+#include <cstdio>
+#define DATA_LOG(...) std::fprintf(stderr, __VA_ARGS__)
+#endif
@@ -0,0 +1,90 @@
+#include "data/dex_prefetch.h"
+
+bool DexPrefetcher::begin(RomImage &rom, const RomIndex &index, BaseType_t core) {
+    rom_ = &rom;
+    index_ = &index;
+    mutex_ = xSemaphoreCreateMutex();
+    if (!mutex_) return false;
+    return xTaskCreatePinnedToCore(taskEntry, "dexPrefetch", 8192, this, 1, &task_, core) == pdPASS;
+}
+
+void DexPrefetcher::request(uint8_t dex_id) {
+    if (!task_) return;
+    center_ = dex_id;
+    xTaskNotifyGive(task_);
+}
+
+bool DexPrefetcher::take(uint8_t dex_id, DexScreenData &out) {
+    if (!mutex_) return false;
+    bool hit = false;
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    for (Slot &slot : slots_) {
+        if (slot.valid && slot.data.dex_id == dex_id) {
+            out = slot.data;
+            slot.lastUse = ++clock_;
+            hit = true;
+            break;
+        }
+    }
+    if (hit) hits_++;
+    else misses_++;
+    xSemaphoreGive(mutex_);
+    return hit;
+}
+
+bool DexPrefetcher::contains(uint8_t dex_id) {
+    bool found = false;
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    for (Slot &slot : slots_) {
+        if (slot.valid && slot.data.dex_id == dex_id) { found = true; break; }
+    }
+    xSemaphoreGive(mutex_);
+    return found;
+}
+
+// 空きスロット、無ければ先読み対象外で最も古いスロットに入れる
+void DexPrefetcher::store(DexScreenData &data, const uint8_t* wanted, int wantedCount) {
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    Slot* victim = nullptr;
+    for (Slot &slot : slots_) {
+        if (!slot.valid) { victim = &slot; break; }
+        bool isWanted = false;
+        for (int i = 0; i < wantedCount; i++) {
+            if (slot.data.dex_id == wanted[i]) { isWanted = true; break; }
+        }
+        if (isWanted) continue;
+        if (!victim || slot.lastUse < victim->lastUse) victim = &slot;
+    }
+    if (victim) {
+        victim->data = std::move(data);
+        victim->valid = true;
+        victim->lastUse = ++clock_;
+    }
+    xSemaphoreGive(mutex_);
+}
+
+void DexPrefetcher::taskEntry(void* arg) {
+    static_cast<DexPrefetcher*>(arg)->run();
+}
+
+void DexPrefetcher::run() {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        uint8_t center = center_;
+        // 押される可能性の高い順
+        const uint8_t wanted[4] = {
+            stepDex(center, +1), stepDex(center, -1),
+            stepDex(center, +10), stepDex(center, -10),
+        };
+
+        for (uint8_t dex : wanted) {
+            if (center_ != center) break;  // 新しい要求が来たらやり直す
+            if (contains(dex)) continue;
+            const PokemonLocation* loc = index_->find(dex);
+            if (!loc) continue;
+
+            DexScreenData data;
+            if (loadDexScreenData(*rom_, *loc, dex, data, atlas_)) store(data, wanted, 4);
+        }
+    }
+}
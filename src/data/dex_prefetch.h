@@ -0,0 +1,52 @@
+#pragma once
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include "data/rom_image.h"
+#include "data/rom_index.h"
+#include "data/dex_screen.h"
+
+/**
+ * @brief 隣の図鑑エントリ（±1, ±10）を別コアで先読みしておくキャッシュ
+ *
+ * request() で現在の Dex番号を知らせると、先読みタスクが周辺エントリを
+ * 読み込み・展開して保持する。take() で当たればROMを読まずに表示できる。
+ */
+class DexPrefetcher {
+public:
+    static constexpr int SLOT_COUNT = 6;  // 周辺4件 + 直前の画面など
+
+    bool begin(RomImage &rom, const RomIndex &index, BaseType_t core = 0);
+    // 展開済みスプライトのアトラスを使う（begin() の前に設定する）
+    void setAtlas(SpriteAtlas* atlas) { atlas_ = atlas; }
+    void request(uint8_t dex_id);
+    bool take(uint8_t dex_id, DexScreenData &out);
+
+    uint32_t hits() const { return hits_; }
+    uint32_t misses() const { return misses_; }
+    void resetStats() { hits_ = misses_ = 0; }
+
+private:
+    struct Slot {
+        DexScreenData data;
+        bool valid = false;
+        uint32_t lastUse = 0;
+    };
+
+    static void taskEntry(void* arg);
+    void run();
+    bool contains(uint8_t dex_id);
+    void store(DexScreenData &data, const uint8_t* wanted, int wantedCount);
+
+    RomImage* rom_ = nullptr;
+    const RomIndex* index_ = nullptr;
+    SpriteAtlas* atlas_ = nullptr;
+    TaskHandle_t task_ = nullptr;
+    SemaphoreHandle_t mutex_ = nullptr;
+    Slot slots_[SLOT_COUNT];
+    volatile uint8_t center_ = 0;
+    uint32_t clock_ = 0;
+    uint32_t hits_ = 0;
+    uint32_t misses_ = 0;
+};
@@ -0,0 +1,64 @@
+#include "data/dex_screen.h"
+#include "data/pokemon_util.h"
+#include "data/pokemon_sprite.h"
+#include "data/sprite_atlas.h"
+#include "data/data_log.h"
+#include <cstring>
+
+// span の内容を固定長バッファへ（あふれた分は切り捨て）
+template <size_t N, typename Len>
+static void copySpan(const RomSpan &src, uint8_t (&dst)[N], Len &length) {
+    size_t n = src.size < N ? src.size : N;
+    if (n) memcpy(dst, src.data, n);
+    length = static_cast<Len>(n);
+}
+
+bool loadDexScreenData(RomImage &rom, const PokemonLocation &loc, uint8_t dex_id, DexScreenData &data,
+                       SpriteAtlas* atlas) {
+    uint8_t scratch[DexScreenData::COMPRESSED_MAX];
+    data.dex_id = dex_id;
+
+    // 名前
+    copySpan(viewPokemonName(rom, loc, scratch), data.name, data.nameLength);
+
+    // 分類名・高さ重さ・説明文（ROM 上で連続）
+    RomSpan entry;
+    if (pokemonDexEntryLength(loc) <= sizeof(scratch)) entry = viewPokemonDexEntry(rom, loc, scratch);
+    if (entry.size == pokemonDexEntryLength(loc)) {
+        copySpan(entry.sub(0, loc.typeLength), data.type, data.typeLength);
+        RomSpan hw = entry.sub(loc.heightWeightOffset - loc.typeOffset, 3);
+        for (size_t i = 0; i < 3; i++) data.heightWeight[i] = i < hw.size ? hw[i] : 0;
+        copySpan(entry.sub(loc.textOffset - loc.typeOffset, loc.textLength), data.text, data.textLength);
+    } else {
+        DATA_LOG("Error: 図鑑データ不足\n");
+        data.typeLength = 0;
+        data.textLength = 0;
+    }
+
+    // パレット
+    getPokemonColorPalette(rom, loc, data.palette);
+
+    // スプライト: アトラスにあれば展開済みを読むだけ
+    if (atlas) {
+        size_t n = atlas->read(dex_id, data.sprite, sizeof(data.sprite), data.spriteWidth, data.spriteHeight);
+        data.spriteSize = n;
+        if (n) return true;
+    }
+
+    // 無ければ ROM から必要な分だけ読みながら展開する
+    // デコーダは呼び出しごとにスタック上に持つので、先読みタスクと同時に展開してよい
+    PicDecoder::Scratch decodeScratch;
+    PicDecoder decoder(decodeScratch);
+    int out_size = decodePokemonSprite(rom, loc, decoder, data.sprite, sizeof(data.sprite));
+    bool ok = out_size > 0 && spriteSizeFromOutput(out_size, data.spriteWidth, data.spriteHeight);
+    data.spriteSize = ok ? out_size : 0;
+
+    if (!ok) DATA_LOG("Dex %d: スプライト展開失敗 size=%d\n", dex_id, out_size);
+    return ok;
+}
+
+uint8_t stepDex(uint8_t dex_id, int delta) {
+    int n = (static_cast<int>(dex_id) - 1 + delta) % 151;
+    if (n < 0) n += 151;
+    return n + 1;
+}
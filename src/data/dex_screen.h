@@ -0,0 +1,42 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "data/rom_image.h"
+#include "data/rom_index.h"
+
+class SpriteAtlas;
+
+/**
+ * @brief 図鑑1画面分の表示データ（スプライトは展開済み）
+ *
+ * 固定長バッファのみで、読み込み・コピーにヒープを使わない。
+ */
+struct DexScreenData {
+    static constexpr size_t NAME_MAX = 16;
+    static constexpr size_t TYPE_MAX = 32;
+    static constexpr size_t TEXT_MAX = 256;
+    static constexpr size_t SPRITE_MAX = 7 * 7 * 16;  // 56x56 の 2bpp（スキャンライン順）
+    static constexpr size_t COMPRESSED_MAX = 1024;    // 読み込み用 scratch
+
+    uint8_t dex_id = 0;
+    uint8_t name[NAME_MAX];
+    uint8_t nameLength = 0;
+    uint8_t type[TYPE_MAX];             // 分類名（〇〇ポケモン）
+    uint8_t typeLength = 0;
+    uint8_t heightWeight[3] = {0, 0, 0};  // 高さ(1) + 重さ(2)
+    uint8_t text[TEXT_MAX];             // 図鑑説明文
+    uint16_t textLength = 0;
+    uint16_t palette[4] = {0, 0, 0, 0};   // RGB565 x4
+    uint8_t sprite[SPRITE_MAX];         // 展開済み 2bpp（スキャンライン順）
+    uint16_t spriteSize = 0;
+    int spriteWidth = 0;
+    int spriteHeight = 0;
+};
+
+// ROM から1画面分を読み込み、スプライトも展開する
+// atlas があればスプライトは展開済みのものを1回で読む
+bool loadDexScreenData(RomImage &rom, const PokemonLocation &loc, uint8_t dex_id, DexScreenData &data,
+                       SpriteAtlas* atlas = nullptr);
+
+// ボタン操作と同じ規則で Dex番号を delta だけ進める（1～151 で循環）
+uint8_t stepDex(uint8_t dex_id, int delta);
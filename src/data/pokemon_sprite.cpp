@@ -0,0 +1,69 @@
+#include "data/pokemon_sprite.h"
+
+// 幅・高さテーブル
+struct SizeMap {
+  int size;
+  int width;
+  int height;
+};
+
+static const SizeMap size_table[] = {
+  {400, 40, 40},
+  {576, 48, 48},
+  {784, 56, 56}
+};
+
+bool spriteSizeFromOutput(int out_size, int &width, int &height) {
+  for (auto& m : size_table) {
+    if (m.size == out_size) { width=m.width; height=m.height; return true; }
+  }
+  width = height = 0;
+  return false;
+}
+
+namespace {
+// PicDecoder の入力を ROM から読む（offset からの相対位置、limit バイトまで）
+struct SpriteFetch {
+    RomImage* rom;
+    uint32_t offset;
+    uint32_t limit;
+};
+
+size_t fetchSprite(uint32_t pos, uint8_t* dst, size_t len, void* ctx) {
+    SpriteFetch* f = static_cast<SpriteFetch*>(ctx);
+    if (pos >= f->limit) return 0;
+    if (len > f->limit - pos) len = f->limit - pos;
+    return f->rom->read(f->offset + pos, dst, len);
+}
+}  // namespace
+
+/**
+ * @brief ポケモンのスプライトを展開する（圧縮データ全体のバッファを持たない）
+ *
+ * @param decoder 展開に使うデコーダ（呼び出し側の Scratch を使う）
+ * @param out 出力先（PicDecoder::OUTPUT_MAX バイト以上）
+ * @return 出力バイト数、失敗時は -1
+ */
+int decodePokemonSprite(RomImage &rom, const PokemonLocation &loc, PicDecoder &decoder,
+                        uint8_t* out, size_t outCap,
+                        PicDecoder::ColumnCallback onColumn, void* ctx) {
+    const uint8_t* mapped = rom.mapped(loc.spriteOffset, loc.spriteLength);
+    if (mapped) return decoder.decode(mapped, loc.spriteLength, out, outCap, onColumn, ctx);
+    SpriteFetch fetch = { &rom, loc.spriteOffset, loc.spriteLength };
+    return decoder.decode(fetchSprite, &fetch, out, outCap, onColumn, ctx);
+}
+
+/**
+ * @brief 圧縮スプライトを展開してみて、使った圧縮データの長さを返す
+ *
+ * スプライトはバンクをまたがないので、バンク末尾までを上限にする。
+ */
+uint16_t measurePokemonSprite(RomImage &rom, uint32_t spriteOffset) {
+    PicDecoder::Scratch scratch;
+    uint8_t out[PicDecoder::OUTPUT_MAX];
+    PicDecoder decoder(scratch);
+    uint32_t bankEnd = (spriteOffset / RomImage::BANK_SIZE + 1) * RomImage::BANK_SIZE;
+    SpriteFetch fetch = { &rom, spriteOffset, bankEnd - spriteOffset };
+    if (decoder.decode(fetchSprite, &fetch, out, sizeof(out)) < 0) return 0;
+    return static_cast<uint16_t>(decoder.consumedBytes());
+}
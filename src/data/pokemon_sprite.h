@@ -0,0 +1,28 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "data/rom_image.h"
+#include "data/rom_index.h"
+#include "data/PicUncompress.h"
+
+// ポケモンのスプライトを ROM から展開する関数（Arduino に依存しないのでホストのツールからも使う）
+
+// 展開後のサイズからスプライトの幅・高さを求める（不明なら false）
+bool spriteSizeFromOutput(int out_size, int &width, int &height);
+
+// スプライトを展開する。マップ済み ROM は直接、それ以外は必要な分だけ ROM から読みながら展開する
+int decodePokemonSprite(
+    RomImage &rom,
+    const PokemonLocation &loc,
+    PicDecoder &decoder,
+    uint8_t* out,
+    size_t outCap,
+    PicDecoder::ColumnCallback onColumn = nullptr,
+    void* ctx = nullptr
+);
+
+// spriteOffset から始まる圧縮スプライトの実際の長さ（展開できなければ 0）
+uint16_t measurePokemonSprite(
+    RomImage &rom,
+    uint32_t spriteOffset
+);
@@ -1,8 +1,6 @@
 #include "data/pokemon_util.h"
 #include "data/rom_util.h"
-
-
-extern TFT_eSPI tft;  // ← これを追加
+#include "data/data_log.h"
 
 
 // Dex番号 -> Index番号逆引き作成   
@@ -16,191 +14,175 @@ std::vector<int> buildDexToIndex(const std::vector<uint8_t>& index_to_dex, size_
 }
 
 
-uint8_t getPokemonSpriteBank(uint8_t indexNumber) {
-    uint8_t spriteBank;
-
-    if (indexNumber == 0x14) {
-        spriteBank = 0x1;
-    }
-    else if (indexNumber == 0xB5) {
-        spriteBank = 0xB;
-    }
-    else if (indexNumber < 0x1F) {
-        spriteBank = 0x9;
-    }
-    else if (indexNumber < 0x49) {
-        spriteBank = 0xA;
-    }
-    else if (indexNumber < 0x73) {
-        spriteBank = 0xB;
-    }
-    else if (indexNumber < 0x98) {
-        spriteBank = 0xC;
+/**
+ * @brief ポインタテーブルをたどり、Dex番号のポケモンの各データのROM内位置を求める
+ *
+ * 索引ファイル作成時に1度だけ使う。通常の画面表示は PokemonLocation から直接読む。
+ *
+ * @param rom 開いているROMイメージ
+ * @param profile ROM バリアントのアドレス表
+ * @param dex_id Dex番号（1～151）
+ * @param dex_to_index Dex番号→Index番号逆引きテーブル
+ * @param loc 求めた位置情報
+ * @return true 成功
+ */
+bool locatePokemon(RomImage &rom, const RomProfile &profile, uint8_t dex_id, const std::vector<int> &dex_to_index, PokemonLocation &loc) {
+    if (dex_id < 1 || dex_id > 151 || dex_id >= dex_to_index.size() || dex_to_index[dex_id] < 0) return false;
+    int index = dex_to_index[dex_id];
+    loc = PokemonLocation();
+
+    // 1. 名前（固定長、0x50終端）
+    loc.nameOffset = profile.nameTable + index * profile.nameLength;
+    std::vector<uint8_t> pokename = readROMData(rom, loc.nameOffset, profile.nameLength, {0x50});
+    loc.nameLength = pokename.size();
+    if (!pokename.empty() && pokename.back() == 0x50) loc.nameLength--;
+
+    // 2. 図鑑データ: Dexポインタテーブルから図鑑アドレスを取得
+    std::vector<uint8_t> dexpointer = readROMData(rom, profile.dexPointers + index * 2, 2);
+    if (dexpointer.size() < 2) return false;
+    uint32_t dex_address = RomImage::toOffset(profile.dexTextBank, readLittleEndian16(dexpointer, 0));
+
+    // 分類名 0x50 高さ(1) 重さ(2) 説明文 0x5F
+    std::vector<uint8_t> dex_detail = readROMData(rom, dex_address, 61);
+    size_t i = 0;
+    while (i + 4 <= dex_detail.size() && dex_detail[i] != 0x50) i++;
+    if (i + 4 > dex_detail.size()) return false;
+    loc.typeOffset = dex_address;
+    loc.typeLength = i;
+    loc.heightWeightOffset = dex_address + i + 1;
+    size_t textStart = i + 4;
+    size_t textEnd = textStart;
+    while (textEnd < dex_detail.size() && dex_detail[textEnd] != 0x5F) textEnd++;
+    loc.textOffset = dex_address + textStart;
+    loc.textLength = textEnd - textStart;
+
+    // 3. スプライト: 一般ポケモンデータベースのポインタ + BANK
+    uint32_t sprite_address = pokemonSpriteOffset(rom, profile, dex_id, index);
+    if (sprite_address == 0) {
+        DATA_LOG("Error: general_pokemon データ不足\n");
+        return false;
     }
-    else {
-        spriteBank = 0xD;
+    loc.spriteOffset = sprite_address;
+    // 1度展開して、実際に使った圧縮データの長さを記録する
+    loc.spriteLength = measurePokemonSprite(rom, sprite_address);
+    if (loc.spriteLength == 0) {
+        DATA_LOG("Error: Dex %d スプライト展開失敗\n", dex_id);
+        return false;
     }
 
-    return spriteBank;
+    // 4. カラーパレット: パレット番号テーブル(150件) → パレット(8バイト)
+    //Mewは151番目ですが、テーブルは150までしかないので、最後の要素を使います。
+    uint8_t paletteIndex = 0;
+    uint8_t paletteSlot = dex_id > 150 ? 149 : dex_id - 1;
+    if (rom.read(profile.paletteIndex + paletteSlot, &paletteIndex, 1) != 1) return false;
+    loc.paletteOffset = profile.palettes + 8 * paletteIndex;
+
+    DATA_LOG("Dex %d: index=%d text=0x%06X sprite=0x%06X(%u) palette=0x%06X\n",
+             dex_id, index, loc.textOffset, loc.spriteOffset, loc.spriteLength, loc.paletteOffset);
+    return true;
 }
 
 /**
- * @brief Dex番号からポケモンの名前（バイナリ配列）を取得する
- * 
- * @param romPath ROMファイルパス
- * @param dex_id Dex番号（0始まり）
- * @param dex_to_index Dex番号→Index番号逆引きテーブル
- * @return std::vector<uint8_t> ポケモン名のバイナリ配列
+ * @brief 全ポケモンの位置を求めて索引を作る
+ *
+ * @return true 全Dex番号の位置が求まった（保存してよい）
  */
-std::vector<uint8_t> getPokemonName(const std::string &romPath, uint8_t dex_id, const std::vector<int> &dex_to_index) {
-    const std::vector<uint8_t> stopByte = {0x50}; // 名前の終端コード
-    const uint32_t nameTableAddress = 0x39446;    // ポケモン名前テーブルの先頭アドレス
-
-    // Index番号をもとにROM内アドレスを計算
-    uint32_t address = nameTableAddress + dex_to_index[dex_id] * 5;
+bool buildRomIndex(RomImage &rom, const RomProfile &profile, const std::vector<int> &dex_to_index, RomIndex &index) {
+    RomIndexKey key;
+    if (!RomIndexKey::fromRom(rom, key)) return false;
+    index.reset(key);
+
+    bool complete = true;
+    for (int dex = 1; dex <= RomIndex::MAX_DEX; dex++) {
+        PokemonLocation loc;
+        if (locatePokemon(rom, profile, dex, dex_to_index, loc)) {
+            index.set(dex, loc);
+        } else {
+            DATA_LOG("Dex %d の位置が求まりません\n", dex);
+            complete = false;
+        }
+    }
+    return complete;
+}
 
-    // 名前データを取得（最大5バイト）
-    std::vector<uint8_t> pokename = readROMData(romPath, address, 5, stopByte);
-    return pokename;
+/**
+ * @brief ポケモンの名前（バイナリ配列）を取得する
+ * 
+ * @param rom 開いているROMイメージ
+ * @param loc ポケモンのROM内位置
+ * @return std::vector<uint8_t> ポケモン名のバイナリ配列（終端0x50は含まない）
+ */
+std::vector<uint8_t> getPokemonName(RomImage &rom, const PokemonLocation &loc) {
+    return readROMData(rom, loc.nameOffset, loc.nameLength);
 }
 
 /**
- * @brief Dex番号を指定してポケモンの図鑑情報全体を取得する
+ * @brief ポケモンの図鑑情報全体を取得する
+ *
+ * 分類名・高さ重さ・説明文はROM上で連続しているので1回で読んで分割する。
  * 
- * @param romPath ROMファイルパス
- * @param dex_id Dex番号（0始まり）
- * @param dex_to_index Dex番号→Index番号逆引きテーブル
+ * @param rom 開いているROMイメージ
+ * @param loc ポケモンのROM内位置
  * @param dex_detail 図鑑情報（説明文など）のバイナリ配列
  * @param poke_information_type タイプ情報のバイナリ配列
  * @param height_weight 高さ・重さ情報のバイナリ配列
  */
 void getPokemonDexDetailFull(
-    const std::string &romPath,
-    uint8_t dex_id,
-    const std::vector<int> &dex_to_index,
+    RomImage &rom,
+    const PokemonLocation &loc,
     std::vector<uint8_t> &dex_detail,
     std::vector<uint8_t> &poke_information_type,
     std::vector<uint8_t> &height_weight
-
 ) {
-    const uint32_t dexPointerAddress = 0x4045B;
-    const uint16_t dexPointerLength = 0x0405d7 - 0x4045B;
-    std::vector<uint8_t> stopByte; // 今回は未使用
-
-    // 1. Dexポインタデータを取得
-    std::vector<uint8_t> dexpointer = readROMData(romPath, dexPointerAddress, dexPointerLength, stopByte);
-
-    // 2. Dex番号からポケモン図鑑アドレスを取得
-    uint32_t dex_address = readLittleEndian16(dexpointer, dex_to_index[dex_id] * 2);
-    Serial.printf("index:%d\n",dex_to_index[dex_id]);
-    // 3. ROM全体アドレスに変換
-    dex_address = (dex_address - 0x4000) + 0x40000;
-    Serial.printf("Dex Address: 0x%06X\n", dex_address);
- 
-    stopByte = {};
-    dex_detail = readROMData(romPath, dex_address, 61, stopByte);
-    Serial.printf("Dex detail size: %d\n", dex_detail.size());
-    // 5. タイプ情報と高さ・重さを分割
-    poke_information_type.clear();
-    size_t i = 0;
-
-    while (true) {
-        if (dex_detail[i] == 0x50) {
-            // 0x50（改行コード）までをbufに格納して削除
-            dex_detail.erase(dex_detail.begin(), dex_detail.begin() + i);
-            Serial.printf("Dex detail size after erase: %d\n", dex_detail.size());
-            // 高さ・重さ情報を抜き出す（4バイト）
-            height_weight.insert(height_weight.end(),dex_detail.begin()+1, dex_detail.begin() + 4);
-            dex_detail.erase(dex_detail.begin(), dex_detail.begin() + 4);
-            Serial.printf("Dex detail size after height/weight erase: %d\n", dex_detail.size());
-            break;
-        }
-        // 0x50までをタイプ情報に格納
-        poke_information_type.push_back(dex_detail[i]);
-        Serial.printf("Type byte: 0x%02X\n", dex_detail[i]);
-        i++;
-    }
-    i=0;
-
-    while(i < dex_detail.size())  {  // 6. 図鑑情報の終端0x5Fまで削除    
-            //0x5Fが入っていたら、そこまで削除して終了
-           if (dex_detail[i] == 0x5F) {
-            dex_detail.erase(dex_detail.begin() + i, dex_detail.end());
-            break;
-           }
-           i++;
+    size_t total = pokemonDexEntryLength(loc);
+    std::vector<uint8_t> entry = readROMData(rom, loc.typeOffset, total);
+    if (entry.size() < total) {
+        DATA_LOG("Error: 図鑑データ不足\n");
+        dex_detail.clear();
+        poke_information_type.clear();
+        height_weight.assign(3, 0);
+        return;
     }
-           Serial.printf("Final Dex detail size: %d\n", dex_detail.size());
+
+    size_t hw = loc.heightWeightOffset - loc.typeOffset;
+    size_t text = loc.textOffset - loc.typeOffset;
+    poke_information_type.assign(entry.begin(), entry.begin() + loc.typeLength);
+    height_weight.assign(entry.begin() + hw, entry.begin() + hw + 3);
+    dex_detail.assign(entry.begin() + text, entry.end());
+    DATA_LOG("Final Dex detail size: %d\n", (int)dex_detail.size());
 }
 
 /**
- * @brief Dex番号からポケモンの圧縮スプライトデータを取得する
+ * @brief ポケモンの圧縮スプライトデータを取得する
  * 
- * @param romPath ROMファイルパス
- * @param dex_id 取得したいポケモンのDex番号 (0始まり)
- * @param dex_to_index Dex番号→Index番号逆引きテーブル
+ * @param rom 開いているROMイメージ
+ * @param loc ポケモンのROM内位置
  * @return std::vector<uint8_t> 圧縮されたスプライトデータ
  */
-std::vector<uint8_t> getCompressedPokemonSprite(const std::string &romPath, uint8_t dex_id, const std::vector<int> &dex_to_index) {
-    const uint32_t SpritePointerAddress = 0x383de;  // 一般ポケモンデータベースの先頭アドレス
-    std::vector<uint8_t> stopByte;                  // 今回は未使用
-
-    // 1. general_pokemonからポインタ情報を取得
-    std::vector<uint8_t> general_pokemon = readROMData(
-        romPath, 
-        SpritePointerAddress + 28 * (dex_id - 1), 
-        28, 
-        stopByte
-    );
-
-    if (general_pokemon.size() < 13) {
-        Serial.println("Error: general_pokemon データ不足");
-        return {};
-    }
-
-    // 2. スプライトアドレスをリトルエンディアンで取得
-    uint32_t sprite_address = readLittleEndian16(general_pokemon, 11); // 11要素目から2バイト
-    Serial.printf("Sprite Address_pre convert: 0x%06X\n", sprite_address);
-
-    // 3. スプライトBANKの決定
-    uint8_t bank = getPokemonSpriteBank(dex_to_index[dex_id]);
-
-    // 4. ROM全体アドレスに変換
-    if(dex_id == 151){
-    sprite_address = 0x4112;    // ミュウのスプライトアドレスは特例
-    }else{
-    sprite_address = (sprite_address - 0x4000) + bank * 0x4000;
-    }
-
-    Serial.printf("Sprite Address: 0x%06X\n", sprite_address);
-    // 5. 圧縮されたスプライトデータを抽出
-    std::vector<uint8_t> compressed_sprite = readROMData(romPath, sprite_address, 700, stopByte);
-
-    return compressed_sprite;
+std::vector<uint8_t> getCompressedPokemonSprite(RomImage &rom, const PokemonLocation &loc) {
+    DATA_LOG("Sprite Address: 0x%06X\n", loc.spriteOffset);
+    return readROMData(rom, loc.spriteOffset, loc.spriteLength);
 }
 
-std::vector<uint16_t> getPokemonColorPalette(const std::string &romPath, uint8_t dex_id) {
+/**
+ * @brief ポケモンのカラーパレット（RGB565 x4）をヒープを使わずに取得する
+ *
+ * @param rom 開いているROMイメージ
+ * @param loc ポケモンのROM内位置
+ * @param palette 出力先（4色）
+ * @return true 成功
+ */
+bool getPokemonColorPalette(RomImage &rom, const PokemonLocation &loc, uint16_t palette[4]) {
      // カラーパレット取得
-    std::vector<uint8_t> stopByte;   
-    std::vector<uint8_t> paletteIndex = readROMData(
-        romPath, 0x72A0E , 150, stopByte
-    );
-    paletteIndex.push_back(paletteIndex[149]);  //Mewは151番目ですが、配列は150までしかないので、最後の要素をコピーして151番目にします。
-
-    std::vector<uint8_t> PokemonPalette = readROMData(
-        romPath, 0x72AA5 + 8 * paletteIndex[dex_id-1] , 8, stopByte
-    );
-    std::vector<uint16_t> binColors;
-
-    for (size_t i = 0; i < 4; ++i) {
-        uint16_t color = readLittleEndian16(PokemonPalette, i * 2);
-        binColors.push_back(color);
+    uint8_t scratch[8];
+    RomSpan PokemonPalette = rom.view(loc.paletteOffset, 8, scratch);
+    if (PokemonPalette.size < 8) {
+        for (int i = 0; i < 4; ++i) palette[i] = 0;
+        return false;
     }
 
-    std::vector<uint16_t> palette;
-    palette.reserve(binColors.size());
-
-   for (auto binColor : binColors) {
+   for (int i = 0; i < 4; ++i) {
+        uint16_t binColor = PokemonPalette.le16(i * 2);
         // --- 1. 分解 ---
         uint8_t r = (binColor & 0b0000000000011111) >> 0;   // 下位5bit
         uint8_t g = (binColor & 0b0000001111100000) >> 5;   // 中間5bit
@@ -211,11 +193,31 @@ std::vector<uint16_t> getPokemonColorPalette(const std::string &romPath, uint8_t
         uint8_t g8 = g * 8;
         uint8_t b8 = b * 8;
 
-        // --- 3. 再び RGB565 にパック ---
-        // --- 3. TFT_eSPI の color565 で 16bit に変換 ---
-        uint16_t packed = tft.color565(r8, g8, b8);
-        //Serial.printf("R:%02X G:%02X B:%02X -> Packed: 0x%04X\n", r8, g8, b8, packed);
-        palette.push_back(packed);
+        // --- 3. RGB565 に詰める（TFT_eSPI の color565 と同じ） ---
+        palette[i] = ((r8 & 0xF8) << 8) | ((g8 & 0xFC) << 3) | (b8 >> 3);
+        //Serial.printf("R:%02X G:%02X B:%02X -> Packed: 0x%04X\n", r8, g8, b8, palette[i]);
    }
-   return palette;
+   return true;
+}
+
+std::vector<uint16_t> getPokemonColorPalette(RomImage &rom, const PokemonLocation &loc) {
+    std::vector<uint16_t> palette(4);
+    getPokemonColorPalette(rom, loc, palette.data());
+    return palette;
+}
+
+// --- ヒープを使わないビュー版 ---
+// マップ済み ROM なら ROM を直接指し、それ以外は scratch に読み込む
+
+RomSpan viewPokemonName(RomImage &rom, const PokemonLocation &loc, uint8_t* scratch) {
+    return rom.view(loc.nameOffset, loc.nameLength, scratch);
+}
+
+// 分類名～説明文の連続した領域（各部分は PokemonLocation のオフセットで切り出す）
+RomSpan viewPokemonDexEntry(RomImage &rom, const PokemonLocation &loc, uint8_t* scratch) {
+    return rom.view(loc.typeOffset, pokemonDexEntryLength(loc), scratch);
+}
+
+RomSpan viewCompressedPokemonSprite(RomImage &rom, const PokemonLocation &loc, uint8_t* scratch) {
+    return rom.view(loc.spriteOffset, loc.spriteLength, scratch);
 }
@@ -1,42 +1,86 @@
 #pragma once
-#include <TFT_eSPI.h>
-#include <arduino.h>
+#include <stdint.h>
+#include <stddef.h>
 #include <vector>
 #include <string>
+#include "data/rom_image.h"
+#include "data/rom_span.h"
+#include "data/rom_index.h"
+#include "data/rom_profile.h"
+#include "data/pokemon_sprite.h"
 
 
 
-uint8_t getPokemonSpriteBank(
-    uint8_t indexNumber
-);
-
 std::vector<int> buildDexToIndex(
     const std::vector<uint8_t>& index_to_dex,
      size_t maxDex =256
 );
 
+bool locatePokemon(
+    RomImage &rom,
+    const RomProfile &profile,
+    uint8_t dex_id,
+    const std::vector<int> &dex_to_index,
+    PokemonLocation &loc
+);
+
+bool buildRomIndex(
+    RomImage &rom,
+    const RomProfile &profile,
+    const std::vector<int> &dex_to_index,
+    RomIndex &index
+);
+
 std::vector<uint8_t> getPokemonName(
-    const std::string &romPath, 
-    uint8_t dex_id, 
-    const std::vector<int> &dex_to_index
+    RomImage &rom, 
+    const PokemonLocation &loc
 );
 
 void getPokemonDexDetailFull(
-    const std::string &romPath,
-    uint8_t dex_id,
-    const std::vector<int> &dex_to_index,
+    RomImage &rom,
+    const PokemonLocation &loc,
     std::vector<uint8_t> &dex_detail,
     std::vector<uint8_t> &poke_information_type,
     std::vector<uint8_t> &height_weight
 );
 
 std::vector<uint8_t> getCompressedPokemonSprite(
-    const std::string &romPath,
-    uint8_t dex_id,
-    const std::vector<int> &dex_to_index
+    RomImage &rom,
+    const PokemonLocation &loc
 );
 
 std::vector<uint16_t> getPokemonColorPalette(
-    const std::string &romPath,
-     uint8_t dex_id
-); 
+    RomImage &rom,
+    const PokemonLocation &loc
+);
+
+bool getPokemonColorPalette(
+    RomImage &rom,
+    const PokemonLocation &loc,
+    uint16_t palette[4]
+);
+
+// --- ヒープを使わないビュー版（scratch は各データ長以上。マップ済み ROM では使われない） ---
+
+// 分類名～説明文の長さ
+inline size_t pokemonDexEntryLength(const PokemonLocation &loc) {
+    return (loc.textOffset + loc.textLength) - loc.typeOffset;
+}
+
+RomSpan viewPokemonName(
+    RomImage &rom,
+    const PokemonLocation &loc,
+    uint8_t* scratch
+);
+
+RomSpan viewPokemonDexEntry(
+    RomImage &rom,
+    const PokemonLocation &loc,
+    uint8_t* scratch
+);
+
+RomSpan viewCompressedPokemonSprite(
+    RomImage &rom,
+    const PokemonLocation &loc,
+    uint8_t* scratch
+);
@@ -0,0 +1,99 @@
+#include "data/rom_cache.h"
+#include <cstdlib>
+#ifdef ARDUINO
+#include <esp_heap_caps.h>
+#endif
+
+static void* cacheAlloc(size_t size, bool usePsram) {
+#ifdef ARDUINO
+    uint32_t caps = usePsram ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT;
+    return heap_caps_malloc(size, caps);
+#else
+    (void)usePsram;
+    return std::malloc(size);
+#endif
+}
+
+static void cacheFree(void* p) {
+#ifdef ARDUINO
+    heap_caps_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+RomPageCache::~RomPageCache() {
+    release();
+}
+
+bool RomPageCache::init(size_t pageSize, size_t pageCount, bool usePsram) {
+    release();
+    // ページサイズは2のべき乗のみ
+    if (pageSize == 0 || (pageSize & (pageSize - 1)) != 0 || pageCount == 0) return false;
+
+    data_ = static_cast<uint8_t*>(cacheAlloc(pageSize * pageCount, usePsram));
+    tags_ = static_cast<uint32_t*>(std::malloc(pageCount * sizeof(uint32_t)));
+    lastUse_ = static_cast<uint32_t*>(std::malloc(pageCount * sizeof(uint32_t)));
+    if (!data_ || !tags_ || !lastUse_) {
+        release();
+        return false;
+    }
+
+    pageSize_ = pageSize;
+    pageCount_ = pageCount;
+    pageShift_ = 0;
+    while ((static_cast<size_t>(1) << pageShift_) < pageSize) pageShift_++;
+    clear();
+    return true;
+}
+
+void RomPageCache::release() {
+    if (data_) cacheFree(data_);
+    std::free(tags_);
+    std::free(lastUse_);
+    data_ = nullptr;
+    tags_ = nullptr;
+    lastUse_ = nullptr;
+    pageSize_ = 0;
+    pageCount_ = 0;
+}
+
+void RomPageCache::clear() {
+    for (size_t i = 0; i < pageCount_; i++) {
+        tags_[i] = INVALID_PAGE;
+        lastUse_[i] = 0;
+    }
+    clock_ = 0;
+    lastSlot_ = 0;
+}
+
+const uint8_t* RomPageCache::lookup(uint32_t pageNo) {
+    if (tags_[lastSlot_] != pageNo) {
+        size_t i = 0;
+        while (i < pageCount_ && tags_[i] != pageNo) i++;
+        if (i == pageCount_) return nullptr;
+        lastSlot_ = i;
+    }
+    lastUse_[lastSlot_] = ++clock_;
+    return data_ + (lastSlot_ << pageShift_);
+}
+
+uint8_t* RomPageCache::insert(uint32_t pageNo) {
+    size_t victim = 0;
+    for (size_t i = 1; i < pageCount_; i++) {
+        if (lastUse_[i] < lastUse_[victim]) victim = i;
+    }
+    tags_[victim] = pageNo;
+    lastUse_[victim] = ++clock_;
+    lastSlot_ = victim;
+    return data_ + (victim << pageShift_);
+}
+
+void RomPageCache::invalidate(uint32_t pageNo) {
+    for (size_t i = 0; i < pageCount_; i++) {
+        if (tags_[i] == pageNo) {
+            tags_[i] = INVALID_PAGE;
+            lastUse_[i] = 0;
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief ROM 読み出し用の固定サイズ LRU ページキャッシュ
+ *
+ * ページサイズ(2のべき乗)とページ数は init() で指定する。
+ * ESP32 では usePsram=true で PSRAM に確保する。
+ */
+class RomPageCache {
+public:
+    struct Stats {
+        uint32_t hits = 0;          // キャッシュにあったページ数
+        uint32_t misses = 0;        // ファイルから読んだページ数
+        uint32_t bytesFetched = 0;  // ファイルから読んだバイト数
+        uint32_t bytesServed = 0;   // 呼び出し側に返したバイト数
+    };
+
+    RomPageCache() = default;
+    ~RomPageCache();
+    RomPageCache(const RomPageCache&) = delete;
+    RomPageCache& operator=(const RomPageCache&) = delete;
+
+    bool init(size_t pageSize, size_t pageCount, bool usePsram = false);
+    void release();
+    void clear();  // 中身だけ捨てる（統計は残す）
+
+    bool enabled() const { return data_ != nullptr; }
+    size_t pageSize() const { return pageSize_; }
+    size_t pageCount() const { return pageCount_; }
+    uint8_t pageShift() const { return pageShift_; }
+
+    // ページがあればそのバッファを返し LRU を更新する。無ければ nullptr
+    const uint8_t* lookup(uint32_t pageNo);
+    // 最も古いページを追い出し、pageNo 用のバッファを返す（呼び出し側が埋める）
+    uint8_t* insert(uint32_t pageNo);
+    // 読み込みに失敗したページを無効にする
+    void invalidate(uint32_t pageNo);
+
+    Stats& stats() { return stats_; }
+    const Stats& stats() const { return stats_; }
+    void resetStats() { stats_ = Stats(); }
+
+private:
+    static constexpr uint32_t INVALID_PAGE = 0xFFFFFFFF;
+
+    uint8_t* data_ = nullptr;      // pageCount * pageSize
+    uint32_t* tags_ = nullptr;     // 各スロットのページ番号
+    uint32_t* lastUse_ = nullptr;  // 各スロットの最終使用時刻
+    size_t pageSize_ = 0;
+    size_t pageCount_ = 0;
+    uint8_t pageShift_ = 0;
+    uint32_t clock_ = 0;
+    size_t lastSlot_ = 0;          // 直前に当たったスロット（連続アクセス用）
+    Stats stats_;
+};
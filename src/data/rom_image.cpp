@@ -0,0 +1,312 @@
+#include "data/rom_image.h"
+#include <cstring>
+#include <vector>
+#ifndef ARDUINO
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// 読み出し中はファイル位置とキャッシュを他タスクに触らせない
+class RomImage::LockGuard {
+public:
+    explicit LockGuard(RomImage &rom) : rom_(rom) { rom_.lock(); }
+    ~LockGuard() { rom_.unlock(); }
+private:
+    RomImage &rom_;
+};
+
+void RomImage::lock() {
+#ifdef ARDUINO
+    if (!mutex_) mutex_ = xSemaphoreCreateMutex();
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+#else
+    mutex_.lock();
+#endif
+}
+
+void RomImage::unlock() {
+#ifdef ARDUINO
+    xSemaphoreGive(mutex_);
+#else
+    mutex_.unlock();
+#endif
+}
+
+RomImage::~RomImage() {
+    close();
+#ifdef ARDUINO
+    if (mutex_) vSemaphoreDelete(mutex_);
+#endif
+}
+
+bool RomImage::open(const std::string &path) {
+    close();
+    LockGuard guard(*this);
+#ifdef ARDUINO
+    file_ = LittleFS.open(path.c_str(), "r");
+    if (!file_) return false;
+    size_ = file_.size();
+#else
+    file_ = std::fopen(path.c_str(), "rb");
+    if (!file_) return false;
+    std::fseek(file_, 0, SEEK_END);
+    size_ = static_cast<size_t>(std::ftell(file_));
+    std::fseek(file_, 0, SEEK_SET);
+#endif
+    path_ = path;
+    pos_ = 0;
+    opened_ = true;
+    return true;
+}
+
+bool RomImage::openMapped(const std::string &source) {
+    close();
+    LockGuard guard(*this);
+#ifdef ARDUINO
+    const esp_partition_t* part = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, source.c_str());
+    if (!part) return false;
+    const void* ptr = nullptr;
+    if (esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA, &ptr, &mapHandle_) != ESP_OK) {
+        return false;
+    }
+    mapped_ = static_cast<const uint8_t*>(ptr);
+    size_ = part->size;
+#else
+    int fd = ::open(source.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (ptr == MAP_FAILED) return false;
+    mapped_ = static_cast<const uint8_t*>(ptr);
+    mapLength_ = st.st_size;
+    size_ = st.st_size;
+#endif
+    path_ = source;
+    pos_ = 0;
+    opened_ = true;
+
+    // 未書き込みのパーティション(0xFF)などを弾く
+    if (!checkHeader()) {
+        closeLocked();
+        return false;
+    }
+#ifdef ARDUINO
+    // パーティションは ROM より大きいので、ヘッダの ROM サイズ(0x148: 32KB << n)で切り詰める
+    // n が 0x00～0x08 以外ならシフトせずに弾く
+    const uint8_t sizeCode = mapped_[0x148];
+    if (sizeCode > 0x08) {
+        closeLocked();
+        return false;
+    }
+    size_t romSize = static_cast<size_t>(0x8000) << sizeCode;
+    if (romSize < size_) size_ = romSize;
+#endif
+    return true;
+}
+
+bool RomImage::openSource(RomSource &source, const std::string &path) {
+    close();
+    LockGuard guard(*this);
+    if (!source.open(path)) return false;
+    source_ = &source;
+    size_ = source.size();
+    path_ = path;
+    pos_ = 0;
+    opened_ = true;
+    return true;
+}
+
+// カートリッジヘッダのチェックサム(0x14D)を検証する
+bool RomImage::checkHeader() {
+    uint8_t header[0x150];
+    if (size_ < sizeof(header)) return false;
+    const uint8_t* p = mapped_;
+    if (!p) {
+        if (readRaw(0, header, sizeof(header)) != sizeof(header)) return false;
+        p = header;
+    }
+    uint8_t sum = 0;
+    for (int i = 0x134; i <= 0x14C; i++) sum = sum - p[i] - 1;
+    return sum == p[0x14D];
+}
+
+void RomImage::close() {
+    LockGuard guard(*this);
+    closeLocked();
+}
+
+void RomImage::closeLocked() {
+    if (!opened_) return;
+    if (source_) {
+        source_->close();
+    } else {
+#ifdef ARDUINO
+        if (mapped_) esp_partition_munmap(mapHandle_);
+        else file_.close();
+#else
+        if (mapped_) munmap(const_cast<uint8_t*>(mapped_), mapLength_);
+        else std::fclose(file_);
+        file_ = nullptr;
+        mapLength_ = 0;
+#endif
+    }
+    mapped_ = nullptr;
+    source_ = nullptr;
+    cache_.clear();
+    opened_ = false;
+    size_ = 0;
+    pos_ = 0;
+}
+
+// --- ROM から読み出し（マップ → キャッシュ → ファイルの順） ---
+size_t RomImage::readRaw(uint32_t offset, uint8_t* dst, size_t len) {
+    if (!opened_ || offset >= size_) return 0;
+    if (len > size_ - offset) len = size_ - offset;
+
+    if (mapped_) {
+        std::memcpy(dst, mapped_ + offset, len);
+        return len;
+    }
+    if (cache_.enabled()) return readCached(offset, dst, len);
+    return readFile(offset, dst, len);
+}
+
+// --- ページキャッシュ経由の読み出し ---
+size_t RomImage::readCached(uint32_t offset, uint8_t* dst, size_t len) {
+    const size_t pageSize = cache_.pageSize();
+    RomPageCache::Stats &stats = cache_.stats();
+    size_t done = 0;
+
+    while (done < len) {
+        uint32_t pos = offset + done;
+        uint32_t pageNo = pos >> cache_.pageShift();
+        uint32_t pageStart = pageNo << cache_.pageShift();
+        size_t inPage = pos - pageStart;
+        size_t n = pageSize - inPage;
+        if (n > len - done) n = len - done;
+
+        const uint8_t* page = cache_.lookup(pageNo);
+        if (page) {
+            stats.hits++;
+        } else {
+            // ROM 末尾のページは短い
+            size_t fill = pageSize;
+            if (fill > size_ - pageStart) fill = size_ - pageStart;
+            uint8_t* slot = cache_.insert(pageNo);
+            if (readFile(pageStart, slot, fill) != fill) {
+                cache_.invalidate(pageNo);
+                break;
+            }
+            stats.misses++;
+            stats.bytesFetched += fill;
+            page = slot;
+        }
+        std::memcpy(dst + done, page + inPage, n);
+        done += n;
+    }
+    stats.bytesServed += done;
+    return done;
+}
+
+// --- ファイル（または RomSource）から直接読み出し ---
+size_t RomImage::readFile(uint32_t offset, uint8_t* dst, size_t len) {
+    if (source_) return source_->read(offset, dst, len);
+#ifdef ARDUINO
+    if (pos_ != offset) file_.seek(offset, SeekSet);
+    size_t n = file_.read(dst, len);
+#else
+    if (pos_ != offset) std::fseek(file_, offset, SEEK_SET);
+    size_t n = std::fread(dst, 1, len, file_);
+#endif
+    pos_ = offset + n;
+    return n;
+}
+
+size_t RomImage::read(uint32_t offset, uint8_t* dst, size_t len) {
+    LockGuard guard(*this);
+    return readRaw(offset, dst, len);
+}
+
+size_t RomImage::read(uint8_t bank, uint16_t addr, uint8_t* dst, size_t len) {
+    LockGuard guard(*this);
+    return readRaw(toOffset(bank, addr), dst, len);
+}
+
+// ページキャッシュのページは先読みタスクに追い出されうるので、直接は指さず scratch にコピーする
+RomSpan RomImage::view(uint32_t offset, size_t len, uint8_t* scratch) {
+    if (mapped_ && offset < size_) {
+        if (len > size_ - offset) len = size_ - offset;
+        return RomSpan(mapped_ + offset, len);
+    }
+    LockGuard guard(*this);
+    size_t n = readRaw(offset, scratch, len);
+    return n ? RomSpan(scratch, n) : RomSpan();
+}
+
+// --- stop シーケンス検索付き読み出し ---
+// ブロック単位で dst に直接読み込み、1バイト終端は memchr、
+// 複数バイト終端は KMP で検索する（状態はブロックをまたいで保持）。
+size_t RomImage::readUntil(uint32_t offset, uint8_t* dst, size_t maxLen,
+                           const uint8_t* stop, size_t stopLen) {
+    LockGuard guard(*this);
+    if (stopLen == 0) return readRaw(offset, dst, maxLen);
+
+    // マップ済みなら ROM 上で直接検索してから1回だけコピーする
+    if (mapped_ && stopLen == 1 && offset < size_) {
+        size_t avail = size_ - offset;
+        size_t len = maxLen < avail ? maxLen : avail;
+        const void* hit = std::memchr(mapped_ + offset, stop[0], len);
+        if (hit) len = static_cast<const uint8_t*>(hit) - (mapped_ + offset) + 1;
+        std::memcpy(dst, mapped_ + offset, len);
+        return len;
+    }
+
+    // KMP の失敗関数（短い終端はスタック上に作る）
+    size_t failBuf[16];
+    std::vector<size_t> failVec;
+    size_t* fail = failBuf;
+    if (stopLen > 16) {
+        failVec.resize(stopLen);
+        fail = failVec.data();
+    }
+    if (stopLen > 1) {
+        fail[0] = 0;
+        for (size_t i = 1, k = 0; i < stopLen; i++) {
+            while (k > 0 && stop[i] != stop[k]) k = fail[k - 1];
+            if (stop[i] == stop[k]) k++;
+            fail[i] = k;
+        }
+    }
+
+    size_t count = 0;
+    size_t matched = 0;  // KMP: 一致済みの長さ
+    while (count < maxLen) {
+        size_t chunk = maxLen - count;
+        if (chunk > READ_BLOCK_SIZE) chunk = READ_BLOCK_SIZE;
+        size_t n = readRaw(offset + count, dst + count, chunk);
+        if (n == 0) break;
+
+        const uint8_t* block = dst + count;
+        if (stopLen == 1) {
+            const void* hit = std::memchr(block, stop[0], n);
+            if (hit) return count + (static_cast<const uint8_t*>(hit) - block) + 1;
+        } else {
+            for (size_t i = 0; i < n; i++) {
+                while (matched > 0 && block[i] != stop[matched]) matched = fail[matched - 1];
+                if (block[i] == stop[matched]) matched++;
+                if (matched == stopLen) return count + i + 1;
+            }
+        }
+        count += n;
+        if (n < chunk) break;  // ファイル終端
+    }
+    return count;
+}
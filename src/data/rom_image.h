@@ -0,0 +1,111 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include "data/rom_cache.h"
+#include "data/rom_span.h"
+#include "data/rom_source.h"
+
+#ifdef ARDUINO
+#include <LittleFS.h>
+#include <esp_partition.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#else
+#include <cstdio>
+#include <mutex>
+#endif
+
+/**
+ * @brief ROMファイルをセッション中1度だけ開いて保持し、読み出しを提供するクラス
+ *
+ * ESP32 では LittleFS のファイル、Linux では通常のファイルを開く。
+ * openMapped() で開いた場合は ROM 全体がアドレス空間にマップされ、
+ * view() でコピーなしの RomSpan が得られる
+ * （ESP32: データパーティションを esp_partition_mmap、Linux: ファイルを mmap）。
+ * openSource() では RomSource（SD カードの SdRomReader、圧縮コンテナの
+ * PackedRomReader など）から読む。
+ * ファイルから読む場合は enableCache() で LRU ページキャッシュを挟める。
+ * 読み出しは内部でロックするので、複数タスクから同時に呼んでよい。
+ */
+class RomImage {
+public:
+    static constexpr uint32_t BANK_SIZE = 0x4000;
+    static constexpr size_t READ_BLOCK_SIZE = 512;  // readUntil の1回の読み出し単位
+
+    RomImage() = default;
+    ~RomImage();
+    RomImage(const RomImage&) = delete;
+    RomImage& operator=(const RomImage&) = delete;
+
+    bool open(const std::string &path);
+    // ESP32: パーティションラベル、Linux: ファイルパスを指定してマップする
+    bool openMapped(const std::string &source);
+    // source で path を開いて読み出し元にする（source は RomImage より長く生存させる）
+    bool openSource(RomSource &source, const std::string &path);
+    void close();
+    bool isOpen() const { return opened_; }
+    bool isMapped() const { return mapped_ != nullptr; }
+    const RomSource* source() const { return source_; }
+    size_t size() const { return size_; }
+    const std::string& path() const { return path_; }
+
+    // 絶対オフセットから len バイト読む。戻り値は実際に読めたバイト数
+    size_t read(uint32_t offset, uint8_t* dst, size_t len);
+    // バンク番号 + GBアドレス(0x0000～0x7FFF)から len バイト読む
+    size_t read(uint8_t bank, uint16_t addr, uint8_t* dst, size_t len);
+    // stop シーケンスが現れるまで（stop を含めて）最大 maxLen バイト読む
+    size_t readUntil(uint32_t offset, uint8_t* dst, size_t maxLen,
+                     const uint8_t* stop, size_t stopLen);
+
+    // ファイル読み出しの下に LRU ページキャッシュを置く（マップ時は不要なので使わない）
+    bool enableCache(size_t pageSize, size_t pageCount, bool usePsram = false) {
+        return cache_.init(pageSize, pageCount, usePsram);
+    }
+    const RomPageCache::Stats& cacheStats() const { return cache_.stats(); }
+    void resetCacheStats() { cache_.resetStats(); }
+    const RomPageCache& cache() const { return cache_; }
+
+    // マップ済みなら offset から len バイトを指すポインタ、それ以外は nullptr
+    const uint8_t* mapped(uint32_t offset, size_t len) const {
+        if (!mapped_ || offset > size_ || len > size_ - offset) return nullptr;
+        return mapped_ + offset;
+    }
+    // マップ済みなら ROM を直接、そうでなければ scratch(len バイト以上)に読み込んで指す
+    // ヒープ確保なし。ROM 末尾で切れた場合は短いビュー、読めなければ空
+    RomSpan view(uint32_t offset, size_t len, uint8_t* scratch);
+
+    // バンク番号 + GBアドレス → ROM ファイル内オフセット
+    static uint32_t toOffset(uint8_t bank, uint16_t addr) {
+        if (addr < BANK_SIZE) return addr;  // バンク0は固定
+        return static_cast<uint32_t>(bank) * BANK_SIZE + (addr - BANK_SIZE);
+    }
+
+private:
+    class LockGuard;
+    void lock();
+    void unlock();
+
+    size_t readRaw(uint32_t offset, uint8_t* dst, size_t len);
+    size_t readCached(uint32_t offset, uint8_t* dst, size_t len);
+    size_t readFile(uint32_t offset, uint8_t* dst, size_t len);
+    bool checkHeader();
+    void closeLocked();
+
+    std::string path_;
+    size_t size_ = 0;
+    uint32_t pos_ = 0;      // 現在のファイル位置（不要な seek を省く）
+    bool opened_ = false;
+    const uint8_t* mapped_ = nullptr;
+    RomSource* source_ = nullptr;
+    RomPageCache cache_;
+#ifdef ARDUINO
+    File file_;
+    esp_partition_mmap_handle_t mapHandle_ = 0;
+    SemaphoreHandle_t mutex_ = nullptr;
+#else
+    FILE* file_ = nullptr;
+    size_t mapLength_ = 0;
+    std::mutex mutex_;
+#endif
+};
@@ -0,0 +1,96 @@
+#include "data/rom_index.h"
+#include <cstring>
+
+bool RomIndexKey::fromRom(RomImage &rom, RomIndexKey &key) {
+    uint8_t buf[3];
+    if (rom.read(0x14D, buf, 3) != 3) return false;
+    key.headerChecksum = buf[0];
+    key.globalChecksum = (buf[1] << 8) | buf[2];
+    return true;
+}
+
+void RomIndex::reset(const RomIndexKey &key) {
+    key_ = key;
+    for (int i = 0; i <= MAX_DEX; i++) {
+        entries_[i] = PokemonLocation();
+        present_[i] = false;
+    }
+    valid_ = true;
+}
+
+const PokemonLocation* RomIndex::find(uint8_t dex_id) const {
+    if (!valid_ || dex_id == 0 || dex_id > MAX_DEX || !present_[dex_id]) return nullptr;
+    return &entries_[dex_id];
+}
+
+void RomIndex::set(uint8_t dex_id, const PokemonLocation &loc) {
+    if (dex_id == 0 || dex_id > MAX_DEX) return;
+    entries_[dex_id] = loc;
+    present_[dex_id] = true;
+}
+
+// --- 索引ファイル読み込み（キー不一致・破損時は false） ---
+bool RomIndex::load(const std::string &path, const RomIndexKey &key) {
+    valid_ = false;
+    FileHeader header;
+    bool ok = false;
+
+#ifdef ARDUINO
+    File f = LittleFS.open(path.c_str(), "r");
+    if (!f) return false;
+    auto readBytes = [&](void* dst, size_t len) { return f.read(static_cast<uint8_t*>(dst), len) == len; };
+#else
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    auto readBytes = [&](void* dst, size_t len) { return std::fread(dst, 1, len, f) == len; };
+#endif
+
+    if (readBytes(&header, sizeof(header)) &&
+        std::memcmp(header.magic, "PKIX", 4) == 0 &&
+        header.version == VERSION &&
+        header.entrySize == sizeof(PokemonLocation) &&
+        header.count <= MAX_DEX &&
+        header.headerChecksum == key.headerChecksum &&
+        header.globalChecksum == key.globalChecksum) {
+        reset(key);
+        valid_ = false;
+        ok = readBytes(&entries_[1], sizeof(PokemonLocation) * header.count);
+        for (int i = 1; i <= header.count; i++) present_[i] = ok;
+    }
+
+#ifdef ARDUINO
+    f.close();
+#else
+    std::fclose(f);
+#endif
+    valid_ = ok;
+    return ok;
+}
+
+// --- 索引ファイル書き出し ---
+bool RomIndex::save(const std::string &path) const {
+    if (!valid_) return false;
+    FileHeader header;
+    std::memcpy(header.magic, "PKIX", 4);
+    header.version = VERSION;
+    header.headerChecksum = key_.headerChecksum;
+    header.count = MAX_DEX;
+    header.globalChecksum = key_.globalChecksum;
+    header.entrySize = sizeof(PokemonLocation);
+    size_t bodySize = sizeof(PokemonLocation) * MAX_DEX;
+
+#ifdef ARDUINO
+    File f = LittleFS.open(path.c_str(), "w");
+    if (!f) return false;
+    bool ok = f.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header)) == sizeof(header) &&
+              f.write(reinterpret_cast<const uint8_t*>(&entries_[1]), bodySize) == bodySize;
+    f.close();
+#else
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    bool ok = std::fwrite(&header, 1, sizeof(header), f) == sizeof(header) &&
+              std::fwrite(&entries_[1], 1, bodySize, f) == bodySize;
+    std::fclose(f);
+#endif
+    return ok;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include "data/rom_image.h"
+
+/**
+ * @brief ポケモン1匹分のデータのROM内位置（ファイル内オフセット）
+ */
+struct PokemonLocation {
+    uint32_t nameOffset = 0;
+    uint32_t typeOffset = 0;          // 分類名（〇〇ポケモン）
+    uint32_t heightWeightOffset = 0;  // 高さ(1) + 重さ(2)
+    uint32_t textOffset = 0;          // 図鑑説明文
+    uint32_t spriteOffset = 0;        // 圧縮スプライト
+    uint32_t paletteOffset = 0;       // パレット(8バイト)
+    uint16_t spriteLength = 0;        // 圧縮スプライトの実際の長さ
+    uint8_t  nameLength = 0;          // 終端0x50を除く
+    uint8_t  typeLength = 0;          // 終端0x50を除く
+    uint8_t  textLength = 0;          // 終端0x5Fを除く
+    uint8_t  reserved[3] = {0, 0, 0};
+};
+
+/**
+ * @brief ROM を識別するキー（カートリッジヘッダのチェックサム）
+ */
+struct RomIndexKey {
+    uint8_t  headerChecksum = 0;   // 0x14D
+    uint16_t globalChecksum = 0;   // 0x14E-0x14F（ビッグエンディアン）
+
+    bool operator==(const RomIndexKey &o) const {
+        return headerChecksum == o.headerChecksum && globalChecksum == o.globalChecksum;
+    }
+    static bool fromRom(RomImage &rom, RomIndexKey &key);
+};
+
+/**
+ * @brief Dex番号ごとの PokemonLocation をまとめた索引
+ *
+ * 初回起動時にポインタテーブルをたどって作り、ファイルに保存する。
+ * 次回以降はファイルを読むだけで、画面表示は直接オフセット読み出しになる。
+ * ヘッダのチェックサムが一致しない索引ファイルは読み込まない。
+ */
+class RomIndex {
+public:
+    static constexpr uint8_t MAX_DEX = 151;
+
+    void reset(const RomIndexKey &key);
+    bool load(const std::string &path, const RomIndexKey &key);
+    bool save(const std::string &path) const;
+
+    bool valid() const { return valid_; }
+    const RomIndexKey& key() const { return key_; }
+    // Dex番号（1～151）の位置。未登録なら nullptr
+    const PokemonLocation* find(uint8_t dex_id) const;
+    void set(uint8_t dex_id, const PokemonLocation &loc);
+
+private:
+    struct FileHeader {
+        char     magic[4];
+        uint16_t version;
+        uint8_t  headerChecksum;
+        uint8_t  count;
+        uint16_t globalChecksum;
+        uint16_t entrySize;
+    };
+    static constexpr uint16_t VERSION = 2;  // 2: spriteLength が実際の圧縮長
+
+    RomIndexKey key_;
+    PokemonLocation entries_[MAX_DEX + 1];
+    bool present_[MAX_DEX + 1] = {};
+    bool valid_ = false;
+};
@@ -0,0 +1,126 @@
+#include "data/rom_lz.h"
+#include <cstring>
+
+namespace {
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t LAST_LITERALS = 5;   // 末尾はリテラルで終える
+constexpr size_t MATCH_LIMIT = 12;    // 末尾からこの範囲では一致を始めない
+constexpr int HASH_BITS = 12;
+constexpr size_t MAX_OFFSET = 0xFFFF;
+
+inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+inline uint32_t hash4(const uint8_t* p) {
+    return (read32(p) * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// 15 以上の長さの追加バイトを書く
+inline bool writeLength(uint8_t* &op, const uint8_t* end, size_t len) {
+    for (; len >= 255; len -= 255) {
+        if (op >= end) return false;
+        *op++ = 255;
+    }
+    if (op >= end) return false;
+    *op++ = static_cast<uint8_t>(len);
+    return true;
+}
+
+inline bool readLength(const uint8_t* &ip, const uint8_t* end, size_t &len) {
+    uint8_t b;
+    do {
+        if (ip >= end) return false;
+        b = *ip++;
+        len += b;
+    } while (b == 255);
+    return true;
+}
+
+bool emitSequence(uint8_t* &op, const uint8_t* opEnd, const uint8_t* lit, size_t litLen,
+                  size_t offset, size_t matchLen) {
+    uint8_t* token = op;
+    if (op >= opEnd) return false;
+    op++;
+    uint8_t t = static_cast<uint8_t>((litLen < 15 ? litLen : 15) << 4);
+    if (litLen >= 15 && !writeLength(op, opEnd, litLen - 15)) return false;
+    if (static_cast<size_t>(opEnd - op) < litLen) return false;
+    std::memcpy(op, lit, litLen);
+    op += litLen;
+    if (matchLen) {
+        if (opEnd - op < 2) return false;
+        *op++ = static_cast<uint8_t>(offset);
+        *op++ = static_cast<uint8_t>(offset >> 8);
+        size_t m = matchLen - MIN_MATCH;
+        t |= static_cast<uint8_t>(m < 15 ? m : 15);
+        if (m >= 15 && !writeLength(op, opEnd, m - 15)) return false;
+    }
+    *token = t;
+    return true;
+}
+}  // namespace
+
+// 貪欲法 + 4バイトハッシュ（ツール側で使う。速度より単純さ優先）
+size_t lzCompress(const uint8_t* src, size_t srcLen, uint8_t* dst, size_t dstCap) {
+    uint32_t table[1 << HASH_BITS];
+    for (uint32_t &t : table) t = UINT32_MAX;
+
+    uint8_t* op = dst;
+    const uint8_t* opEnd = dst + dstCap;
+    size_t anchor = 0;
+    size_t pos = 0;
+
+    if (srcLen > MATCH_LIMIT) {
+        const size_t matchEnd = srcLen - LAST_LITERALS;
+        while (pos + MATCH_LIMIT <= srcLen) {
+            uint32_t h = hash4(src + pos);
+            uint32_t cand = table[h];
+            table[h] = static_cast<uint32_t>(pos);
+            if (cand == UINT32_MAX || pos - cand > MAX_OFFSET || read32(src + cand) != read32(src + pos)) {
+                pos++;
+                continue;
+            }
+            size_t len = MIN_MATCH;
+            while (pos + len < matchEnd && src[cand + len] == src[pos + len]) len++;
+            if (!emitSequence(op, opEnd, src + anchor, pos - anchor, pos - cand, len)) return 0;
+            pos += len;
+            anchor = pos;
+        }
+    }
+    if (!emitSequence(op, opEnd, src + anchor, srcLen - anchor, 0, 0)) return 0;
+    return op - dst;
+}
+
+int lzDecompress(const uint8_t* src, size_t srcLen, uint8_t* dst, size_t dstCap) {
+    const uint8_t* ip = src;
+    const uint8_t* ipEnd = src + srcLen;
+    uint8_t* op = dst;
+    uint8_t* opEnd = dst + dstCap;
+
+    while (ip < ipEnd) {
+        uint8_t token = *ip++;
+        size_t litLen = token >> 4;
+        if (litLen == 15 && !readLength(ip, ipEnd, litLen)) return -1;
+        if (static_cast<size_t>(ipEnd - ip) < litLen || static_cast<size_t>(opEnd - op) < litLen) return -1;
+        std::memcpy(op, ip, litLen);
+        ip += litLen;
+        op += litLen;
+        if (ip == ipEnd) break;  // 最後のシーケンス
+
+        if (ipEnd - ip < 2) return -1;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        size_t matchLen = token & 0x0F;
+        if (matchLen == 15 && !readLength(ip, ipEnd, matchLen)) return -1;
+        matchLen += MIN_MATCH;
+        if (offset == 0 || offset > static_cast<size_t>(op - dst)) return -1;
+        if (static_cast<size_t>(opEnd - op) < matchLen) return -1;
+        // 重なりがありうるので1バイトずつ
+        const uint8_t* match = op - offset;
+        for (size_t i = 0; i < matchLen; i++) op[i] = match[i];
+        op += matchLen;
+    }
+    return static_cast<int>(op - dst);
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief ROM ブロック用の LZ77 系圧縮（LZ4 ブロック形式と同じ符号）
+ *
+ * シーケンス = トークン(上位4bit: リテラル長, 下位4bit: 一致長-4)
+ *            + [リテラル長の追加バイト] + リテラル + オフセット(LE16) + [一致長の追加バイト]
+ * 追加バイトは 255 が続く限り加算する。最後のシーケンスはリテラルのみ。
+ * 展開側はヒープを使わず、壊れた入力でも dst の外には書かない。
+ */
+
+// 圧縮後の最大サイズ（圧縮できないデータでも収まる大きさ）
+inline size_t lzCompressBound(size_t srcLen) { return srcLen + srcLen / 255 + 16; }
+
+// src を圧縮して dst に書く。戻り値は圧縮後のバイト数（dstCap 不足なら 0）
+size_t lzCompress(const uint8_t* src, size_t srcLen, uint8_t* dst, size_t dstCap);
+
+// src を dst に展開する。戻り値は展開後のバイト数（入力が壊れていれば -1）
+int lzDecompress(const uint8_t* src, size_t srcLen, uint8_t* dst, size_t dstCap);
@@ -0,0 +1,189 @@
+#include "data/rom_pack.h"
+#include "data/rom_lz.h"
+#include <cstring>
+#include <cstdlib>
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+
+namespace {
+uint32_t nowMicros() {
+#ifdef ARDUINO
+    return micros();
+#else
+    using namespace std::chrono;
+    return static_cast<uint32_t>(duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count());
+#endif
+}
+}  // namespace
+
+// --- パック（ホスト側） ---
+bool packRom(const uint8_t* rom, size_t romSize, uint8_t blockShift, std::vector<uint8_t> &out) {
+    if (blockShift < 8 || blockShift > 15 || romSize == 0) return false;
+    const size_t blockSize = static_cast<size_t>(1) << blockShift;
+    const uint32_t blockCount = static_cast<uint32_t>((romSize + blockSize - 1) / blockSize);
+
+    RomPackHeader header;
+    std::memcpy(header.magic, "RPAK", 4);
+    header.version = ROM_PACK_VERSION;
+    header.blockShift = blockShift;
+    header.reserved = 0;
+    header.romSize = static_cast<uint32_t>(romSize);
+    header.blockCount = blockCount;
+
+    std::vector<uint32_t> offsets(blockCount + 1);
+    std::vector<uint8_t> body;
+    std::vector<uint8_t> tmp(lzCompressBound(blockSize));
+    const uint32_t dataStart = sizeof(header) + sizeof(uint32_t) * (blockCount + 1);
+
+    for (uint32_t b = 0; b < blockCount; b++) {
+        size_t start = static_cast<size_t>(b) * blockSize;
+        size_t len = romSize - start < blockSize ? romSize - start : blockSize;
+        size_t n = lzCompress(rom + start, len, tmp.data(), tmp.size());
+        offsets[b] = dataStart + static_cast<uint32_t>(body.size());
+        if (n == 0 || n >= len) {
+            body.insert(body.end(), rom + start, rom + start + len);  // 無圧縮で格納
+        } else {
+            body.insert(body.end(), tmp.begin(), tmp.begin() + n);
+        }
+    }
+    offsets[blockCount] = dataStart + static_cast<uint32_t>(body.size());
+
+    out.resize(dataStart + body.size());
+    std::memcpy(out.data(), &header, sizeof(header));
+    std::memcpy(out.data() + sizeof(header), offsets.data(), sizeof(uint32_t) * offsets.size());
+    std::memcpy(out.data() + dataStart, body.data(), body.size());
+    return true;
+}
+
+// --- 読み出し ---
+PackedRomReader::~PackedRomReader() {
+    close();
+}
+
+void PackedRomReader::freeBuffers() {
+    for (Slot &s : slots_) std::free(s.data);
+    slots_.clear();
+    std::free(packed_);
+    packed_ = nullptr;
+}
+
+bool PackedRomReader::open(const std::string &path) {
+    close();
+#ifdef ARDUINO
+    file_ = LittleFS.open(path.c_str(), "r");
+    if (!file_) return false;
+#else
+    file_ = std::fopen(path.c_str(), "rb");
+    if (!file_) return false;
+#endif
+    opened_ = true;
+
+    bool ok = readFile(0, reinterpret_cast<uint8_t*>(&header_), sizeof(header_)) == sizeof(header_) &&
+              std::memcmp(header_.magic, "RPAK", 4) == 0 &&
+              header_.version == ROM_PACK_VERSION &&
+              header_.blockShift >= 8 && header_.blockShift <= 15 &&
+              header_.blockCount == (header_.romSize + (1u << header_.blockShift) - 1) >> header_.blockShift;
+    if (ok) {
+        blockSize_ = static_cast<size_t>(1) << header_.blockShift;
+        offsets_.resize(header_.blockCount + 1);
+        size_t tableBytes = sizeof(uint32_t) * offsets_.size();
+        ok = readFile(sizeof(header_), reinterpret_cast<uint8_t*>(offsets_.data()), tableBytes) == tableBytes;
+        for (uint32_t b = 0; ok && b < header_.blockCount; b++) {
+            uint32_t len = offsets_[b + 1] - offsets_[b];
+            ok = offsets_[b + 1] >= offsets_[b] && len <= blockSize_;
+        }
+    }
+    if (ok) {
+        packed_ = static_cast<uint8_t*>(std::malloc(blockSize_));
+        slots_.resize(slotCount_);
+        for (Slot &s : slots_) {
+            s.data = static_cast<uint8_t*>(std::malloc(blockSize_));
+            ok = ok && s.data;
+        }
+        ok = ok && packed_;
+    }
+    if (!ok) close();
+    return ok;
+}
+
+void PackedRomReader::close() {
+    if (opened_) {
+#ifdef ARDUINO
+        file_.close();
+#else
+        std::fclose(file_);
+        file_ = nullptr;
+#endif
+    }
+    freeBuffers();
+    offsets_.clear();
+    header_ = RomPackHeader();
+    blockSize_ = 0;
+    opened_ = false;
+}
+
+size_t PackedRomReader::readFile(uint32_t offset, uint8_t* dst, size_t len) {
+#ifdef ARDUINO
+    file_.seek(offset, SeekSet);
+    return file_.read(dst, len);
+#else
+    std::fseek(file_, offset, SEEK_SET);
+    return std::fread(dst, 1, len, file_);
+#endif
+}
+
+// ブロックを展開済みスロットから探し、無ければ最も古いスロットに展開する
+const uint8_t* PackedRomReader::loadBlock(uint32_t block) {
+    Slot* victim = &slots_[0];
+    for (Slot &s : slots_) {
+        if (s.block == static_cast<int32_t>(block)) {
+            s.lastUse = ++clock_;
+            stats_.blockHits++;
+            return s.data;
+        }
+        if (s.lastUse < victim->lastUse) victim = &s;
+    }
+
+    size_t rawLen = header_.romSize - static_cast<size_t>(block) * blockSize_;
+    if (rawLen > blockSize_) rawLen = blockSize_;
+    uint32_t packedLen = offsets_[block + 1] - offsets_[block];
+
+    victim->block = -1;
+    if (packedLen == rawLen) {
+        // 無圧縮ブロックはスロットに直接読む
+        if (readFile(offsets_[block], victim->data, rawLen) != rawLen) return nullptr;
+    } else {
+        if (readFile(offsets_[block], packed_, packedLen) != packedLen) return nullptr;
+        uint32_t start = nowMicros();
+        int n = lzDecompress(packed_, packedLen, victim->data, blockSize_);
+        stats_.decompressMicros += nowMicros() - start;
+        if (n != static_cast<int>(rawLen)) return nullptr;
+    }
+    stats_.blockMisses++;
+    stats_.bytesRead += packedLen;
+    victim->block = static_cast<int32_t>(block);
+    victim->lastUse = ++clock_;
+    return victim->data;
+}
+
+size_t PackedRomReader::read(uint32_t offset, uint8_t* dst, size_t len) {
+    if (!opened_ || offset >= header_.romSize) return 0;
+    if (len > header_.romSize - offset) len = header_.romSize - offset;
+
+    size_t done = 0;
+    while (done < len) {
+        uint32_t pos = offset + done;
+        uint32_t block = pos >> header_.blockShift;
+        size_t inBlock = pos & (blockSize_ - 1);
+        const uint8_t* data = loadBlock(block);
+        if (!data) break;
+        size_t n = blockSize_ - inBlock;
+        if (n > len - done) n = len - done;
+        std::memcpy(dst + done, data + inBlock, n);
+        done += n;
+    }
+    return done;
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include "data/rom_source.h"
+
+#ifdef ARDUINO
+#include <LittleFS.h>
+#else
+#include <cstdio>
+#endif
+
+/**
+ * @brief 圧縮 ROM コンテナ（.rpk）
+ *
+ * ROM を固定長ブロック（既定 4KB）ごとに独立して rom_lz で圧縮し、
+ * 先頭にブロックのオフセット表を置く。任意のオフセットを読むには
+ * そのブロックだけを展開すればよい。圧縮しても縮まないブロックは無圧縮で格納する
+ * （ブロック長 == 展開後の長さで判別）。
+ *
+ *   RomPackHeader
+ *   uint32_t offsets[blockCount + 1]   // ファイル先頭からの位置。ブロック i = [offsets[i], offsets[i+1])
+ *   ブロックデータ
+ */
+struct RomPackHeader {
+    char magic[4];          // "RPAK"
+    uint16_t version;
+    uint8_t blockShift;     // ブロック長 = 1 << blockShift
+    uint8_t reserved;
+    uint32_t romSize;       // 展開後の ROM サイズ
+    uint32_t blockCount;
+};
+static_assert(sizeof(RomPackHeader) == 16, "RomPackHeader layout");
+
+constexpr uint16_t ROM_PACK_VERSION = 1;
+
+// rom をコンテナ形式に圧縮して out に書く（ホスト側の rom_pack ツールで使う）
+bool packRom(const uint8_t* rom, size_t romSize, uint8_t blockShift, std::vector<uint8_t> &out);
+
+/**
+ * @brief .rpk を読み、要求されたブロックだけを展開して返す読み出し元
+ *
+ * 展開済みブロックを少数の LRU スロットに保持する。
+ * オフセット表は open() 時に読み込んで RAM に置く（1MB / 4KB で約1KB）。
+ */
+class PackedRomReader : public RomSource {
+public:
+    struct Stats {
+        uint32_t blockHits = 0;
+        uint32_t blockMisses = 0;       // 展開したブロック数
+        uint32_t bytesRead = 0;         // ファイルから読んだ圧縮データ
+        uint32_t decompressMicros = 0;  // 展開に掛かった時間の合計
+    };
+
+    explicit PackedRomReader(size_t cacheBlocks = 4) : slotCount_(cacheBlocks ? cacheBlocks : 1) {}
+    ~PackedRomReader() override;
+    PackedRomReader(const PackedRomReader&) = delete;
+    PackedRomReader& operator=(const PackedRomReader&) = delete;
+
+    bool open(const std::string &path) override;
+    void close() override;
+    size_t size() const override { return header_.romSize; }
+    size_t read(uint32_t offset, uint8_t* dst, size_t len) override;
+
+    size_t blockSize() const { return blockSize_; }
+    // 圧縮後のブロックデータの合計
+    size_t packedSize() const { return offsets_.empty() ? 0 : offsets_.back() - offsets_.front(); }
+
+    const Stats& stats() const { return stats_; }
+    void resetStats() { stats_ = Stats(); }
+
+private:
+    struct Slot {
+        uint8_t* data = nullptr;
+        int32_t block = -1;
+        uint32_t lastUse = 0;
+    };
+
+    const uint8_t* loadBlock(uint32_t block);
+    size_t readFile(uint32_t offset, uint8_t* dst, size_t len);
+    void freeBuffers();
+
+    RomPackHeader header_ = {};
+    std::vector<uint32_t> offsets_;
+    size_t blockSize_ = 0;
+    size_t slotCount_;
+    std::vector<Slot> slots_;
+    uint8_t* packed_ = nullptr;  // 圧縮ブロックの読み込み先
+    uint32_t clock_ = 0;
+    bool opened_ = false;
+    Stats stats_;
+#ifdef ARDUINO
+    File file_;
+#else
+    FILE* file_ = nullptr;
+#endif
+};
@@ -0,0 +1,201 @@
+#include "data/rom_profile.h"
+#include "font_table.h"
+#include <cstring>
+
+// 対応 ROM の一覧（新しいバリアントはここに追加する）
+static const RomProfile romProfiles[] = {
+    {
+        "ポケットモンスター 青 (日本)",
+        "POKEMON BLUE", 0x00, 0,
+        0x42784, 190,   // indexToDex
+        0x39446, 5,     // nameTable
+        0x4045B, 0x10,  // dexPointers
+        0x383DE,        // baseStats
+        0x4112,         // mewSprite
+        0x72A0E,        // paletteIndex
+        0x72AA5,        // palettes
+        0x12881, 320,   // mapTileset
+        &fontTable,
+    },
+};
+
+bool RomHeader::read(RomImage &rom, RomHeader &header) {
+    uint8_t buf[0x150 - 0x134];
+    if (rom.read(0x134, buf, sizeof(buf)) != sizeof(buf)) return false;
+    auto at = [&](uint32_t addr) { return buf[addr - 0x134]; };
+
+    header = RomHeader();
+    std::memcpy(header.title, buf, 16);
+    header.cgbFlag = at(0x143);
+    // CGB 対応カートリッジはタイトルが15文字まで
+    if (header.cgbFlag & 0x80) header.title[15] = '\0';
+    header.sgbFlag = at(0x146);
+    header.cartridgeType = at(0x147);
+    header.romSize = at(0x148);
+    header.destination = at(0x14A);
+    header.version = at(0x14C);
+    header.headerChecksum = at(0x14D);
+    header.globalChecksum = (at(0x14E) << 8) | at(0x14F);
+    return true;
+}
+
+// --- CRC32（テーブル方式） ---
+static uint32_t crcTable[256];
+
+static void buildCrcTable() {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+        crcTable[i] = c;
+    }
+}
+
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t len) {
+    if (crcTable[1] == 0) buildCrcTable();
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// キャッシュファイルの中身
+struct RomIdentityCache {
+    char     magic[4];
+    uint8_t  headerChecksum;
+    uint8_t  globalChecksumOk;
+    uint16_t globalChecksum;
+    char     title[16];
+    uint32_t size;
+    uint32_t crc32;
+};
+
+static bool loadIdentityCache(const std::string &path, RomIdentityCache &cache) {
+#ifdef ARDUINO
+    File f = LittleFS.open(path.c_str(), "r");
+    if (!f) return false;
+    bool ok = f.read(reinterpret_cast<uint8_t*>(&cache), sizeof(cache)) == sizeof(cache);
+    f.close();
+#else
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    bool ok = std::fread(&cache, 1, sizeof(cache), f) == sizeof(cache);
+    std::fclose(f);
+#endif
+    return ok && std::memcmp(cache.magic, "RMID", 4) == 0;
+}
+
+static void saveIdentityCache(const std::string &path, const RomIdentityCache &cache) {
+#ifdef ARDUINO
+    File f = LittleFS.open(path.c_str(), "w");
+    if (!f) return;
+    f.write(reinterpret_cast<const uint8_t*>(&cache), sizeof(cache));
+    f.close();
+#else
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return;
+    std::fwrite(&cache, 1, sizeof(cache), f);
+    std::fclose(f);
+#endif
+}
+
+/**
+ * @brief ROM のヘッダを読み、CRC32 と全体チェックサムを（キャッシュがあればそこから）得る
+ *
+ * @param rom 開いているROMイメージ
+ * @param cachePath 識別結果のキャッシュファイル
+ * @param id 識別結果
+ * @return true ヘッダが読めた
+ */
+bool identifyRom(RomImage &rom, const std::string &cachePath, RomIdentity &id) {
+    id = RomIdentity();
+    if (!RomHeader::read(rom, id.header)) return false;
+
+    RomIdentityCache cache;
+    if (loadIdentityCache(cachePath, cache) &&
+        cache.headerChecksum == id.header.headerChecksum &&
+        cache.globalChecksum == id.header.globalChecksum &&
+        cache.size == rom.size() &&
+        std::memcmp(cache.title, id.header.title, 16) == 0) {
+        id.crc32 = cache.crc32;
+        id.globalChecksumOk = cache.globalChecksumOk;
+        return true;
+    }
+
+    // ROM 全体を1回だけ走査（全体チェックサムは 0x14E-0x14F 以外の全バイトの合計）
+    uint8_t buf[1024];
+    uint32_t crc = 0;
+    uint16_t sum = 0;
+    for (uint32_t offset = 0; offset < rom.size(); ) {
+        size_t n = rom.read(offset, buf, sizeof(buf));
+        if (n == 0) break;
+        crc = crc32Update(crc, buf, n);
+        for (size_t i = 0; i < n; i++) {
+            uint32_t addr = offset + i;
+            if (addr != 0x14E && addr != 0x14F) sum += buf[i];
+        }
+        offset += n;
+    }
+    id.crc32 = crc;
+    id.globalChecksumOk = (sum == id.header.globalChecksum);
+
+    std::memcpy(cache.magic, "RMID", 4);
+    cache.headerChecksum = id.header.headerChecksum;
+    cache.globalChecksumOk = id.globalChecksumOk;
+    cache.globalChecksum = id.header.globalChecksum;
+    std::memcpy(cache.title, id.header.title, 16);
+    cache.size = rom.size();
+    cache.crc32 = id.crc32;
+    saveIdentityCache(cachePath, cache);
+    return true;
+}
+
+const RomProfile* findRomProfile(const RomIdentity &id) {
+    for (const RomProfile &p : romProfiles) {
+        if (std::strcmp(p.title, id.header.title) != 0) continue;
+        if (p.destination != id.header.destination) continue;
+        if (p.crc32 != 0 && p.crc32 != id.crc32) continue;
+        return &p;
+    }
+    return nullptr;
+}
+
+uint8_t getPokemonSpriteBank(uint8_t indexNumber) {
+    uint8_t spriteBank;
+
+    if (indexNumber == 0x14) {
+        spriteBank = 0x1;
+    }
+    else if (indexNumber == 0xB5) {
+        spriteBank = 0xB;
+    }
+    else if (indexNumber < 0x1F) {
+        spriteBank = 0x9;
+    }
+    else if (indexNumber < 0x49) {
+        spriteBank = 0xA;
+    }
+    else if (indexNumber < 0x73) {
+        spriteBank = 0xB;
+    }
+    else if (indexNumber < 0x98) {
+        spriteBank = 0xC;
+    }
+    else {
+        spriteBank = 0xD;
+    }
+
+    return spriteBank;
+}
+
+/**
+ * @brief 一般ポケモンデータベースのポインタ + BANK から圧縮スプライトの位置を求める
+ *
+ * @param index Index番号（dex_to_index で引いたもの）
+ * @return ファイル内オフセット、読めなければ 0
+ */
+uint32_t pokemonSpriteOffset(RomImage &rom, const RomProfile &profile, uint8_t dex_id, int index) {
+    if (dex_id == 151) return profile.mewSprite;    // ミュウのスプライトアドレスは特例
+    uint8_t pointer[2];
+    if (rom.read(profile.baseStats + 28 * (dex_id - 1) + 11, pointer, 2) != 2) return 0;
+    uint16_t addr = pointer[0] | (pointer[1] << 8);
+    return RomImage::toOffset(getPokemonSpriteBank(index), addr);
+}
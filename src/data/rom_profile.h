@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <map>
+#include "data/rom_image.h"
+
+struct FontInfo;  // font_table.h
+
+/**
+ * @brief カートリッジヘッダ（0x134～0x14F）
+ */
+struct RomHeader {
+    char     title[17] = {};      // 0x134-0x143（0埋め、終端付き）
+    uint8_t  cgbFlag = 0;         // 0x143
+    uint8_t  sgbFlag = 0;         // 0x146
+    uint8_t  cartridgeType = 0;   // 0x147
+    uint8_t  romSize = 0;         // 0x148（32KB << n）
+    uint8_t  destination = 0;     // 0x14A（0=日本）
+    uint8_t  version = 0;         // 0x14C
+    uint8_t  headerChecksum = 0;  // 0x14D
+    uint16_t globalChecksum = 0;  // 0x14E-0x14F（ビッグエンディアン）
+
+    static bool read(RomImage &rom, RomHeader &header);
+};
+
+/**
+ * @brief ROM の識別情報（ヘッダ + 全体の CRC32）
+ *
+ * CRC32 と 16bit 合計チェックサムは ROM 全体を読む必要があるので、
+ * ヘッダをキーにしてファイルにキャッシュし、2回目以降はヘッダ読み出しだけで済ませる。
+ */
+struct RomIdentity {
+    RomHeader header;
+    uint32_t  crc32 = 0;
+    bool      globalChecksumOk = false;  // ヘッダの全体チェックサムと実データが一致
+};
+
+bool identifyRom(RomImage &rom, const std::string &cachePath, RomIdentity &id);
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t len);
+
+/**
+ * @brief ROM バリアントごとのアドレス・文字コード表
+ */
+struct RomProfile {
+    const char* name;
+
+    // 判定条件（title は前方一致ではなく完全一致、crc32 が 0 なら問わない）
+    const char* title;
+    uint8_t     destination;
+    uint32_t    crc32;
+
+    // 各テーブルのファイル内オフセット
+    uint32_t indexToDex;        // Index番号 → 図鑑番号
+    uint16_t indexToDexLength;
+    uint32_t nameTable;         // ポケモン名前テーブル
+    uint8_t  nameLength;
+    uint32_t dexPointers;       // 図鑑データのポインタテーブル
+    uint8_t  dexTextBank;       // 図鑑データのバンク
+    uint32_t baseStats;         // 一般ポケモンデータベース（28バイト/匹）
+    uint32_t mewSprite;         // ミュウのスプライト（特例）
+    uint32_t paletteIndex;      // パレット番号テーブル
+    uint32_t palettes;          // パレット本体（8バイト/個）
+    uint32_t mapTileset;        // 図鑑枠のタイルセット
+    uint16_t mapTilesetLength;
+
+    const std::map<uint8_t, FontInfo>* charset;  // ROM 内フォントの文字コード表
+};
+
+const RomProfile* findRomProfile(const RomIdentity &id);
+
+// Index番号のポケモンのスプライトが入っているバンク
+uint8_t getPokemonSpriteBank(uint8_t indexNumber);
+// Dex番号（Index番号 index）のポケモンの圧縮スプライトのファイル内オフセット（読めなければ 0）
+uint32_t pokemonSpriteOffset(RomImage &rom, const RomProfile &profile, uint8_t dex_id, int index);
@@ -0,0 +1,209 @@
+#include "data/rom_sd.h"
+#include <cstring>
+#include <cstdlib>
+#ifdef ARDUINO
+#include <esp_heap_caps.h>
+#else
+#include <dirent.h>
+#endif
+
+SdRomReader::~SdRomReader() {
+    close();
+    for (Buffer &buf : buffers_) {
+#ifdef ARDUINO
+        heap_caps_free(buf.data);
+#else
+        std::free(buf.data);
+#endif
+        buf.data = nullptr;
+    }
+}
+
+// DMA で直接読めるよう、4バイト境界の DMA 対応メモリに確保する
+bool SdRomReader::allocBuffers() {
+    for (Buffer &buf : buffers_) {
+        if (buf.data) continue;
+#ifdef ARDUINO
+        buf.data = static_cast<uint8_t*>(heap_caps_malloc(BLOCK_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_8BIT));
+#else
+        buf.data = static_cast<uint8_t*>(std::malloc(BLOCK_SIZE));
+#endif
+        if (!buf.data) return false;
+    }
+    return true;
+}
+
+#ifdef ARDUINO
+bool SdRomReader::begin(SPIClass &spi, uint8_t csPin, uint32_t frequency) {
+    if (!SD.begin(csPin, spi, frequency)) return false;
+    if (!allocBuffers()) return false;
+    if (!ioMutex_) ioMutex_ = xSemaphoreCreateMutex();
+    if (!ioMutex_) return false;
+    if (!task_ && xTaskCreatePinnedToCore(taskEntry, "sdRomRead", 4096, this, 2, &task_, 0) != pdPASS) {
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::string> SdRomReader::listRoms(const std::string &dir) {
+    std::vector<std::string> result;
+    File root = SD.open(dir.c_str());
+    if (!root || !root.isDirectory()) return result;
+    for (File f = root.openNextFile(); f; f = root.openNextFile()) {
+        std::string name = f.name();
+        if (!f.isDirectory() && name.size() > 3 && name.compare(name.size() - 3, 3, ".gb") == 0) {
+            result.push_back(dir + (dir.back() == '/' ? "" : "/") + name);
+        }
+    }
+    return result;
+}
+
+bool SdRomReader::open(const std::string &path) {
+    close();
+    xSemaphoreTake(ioMutex_, portMAX_DELAY);
+    file_ = SD.open(path.c_str(), "r");
+    opened_ = static_cast<bool>(file_);
+    size_ = opened_ ? file_.size() : 0;
+    for (Buffer &buf : buffers_) buf.block = -1;
+    xSemaphoreGive(ioMutex_);
+    return opened_;
+}
+
+void SdRomReader::close() {
+    if (!opened_) return;
+    xSemaphoreTake(ioMutex_, portMAX_DELAY);
+    file_.close();
+    opened_ = false;
+    size_ = 0;
+    pendingBlock_ = -1;
+    for (Buffer &buf : buffers_) buf.block = -1;
+    xSemaphoreGive(ioMutex_);
+}
+
+void SdRomReader::taskEntry(void* arg) {
+    static_cast<SdRomReader*>(arg)->run();
+}
+
+// 先読みタスク: 要求されたブロックを裏のバッファに読む
+void SdRomReader::run() {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        xSemaphoreTake(ioMutex_, portMAX_DELAY);
+        int32_t block = pendingBlock_;
+        pendingBlock_ = -1;
+        if (opened_ && block >= 0 && loadBlock(buffers_[pendingSlot_], block)) stats_.prefetches++;
+        xSemaphoreGive(ioMutex_);
+    }
+}
+
+void SdRomReader::requestPrefetch(int slot, int32_t block) {
+    pendingSlot_ = slot;
+    pendingBlock_ = block;
+    xTaskNotifyGive(task_);
+}
+#else
+bool SdRomReader::begin(const std::string &rootDir) {
+    root_ = rootDir;
+    while (!root_.empty() && root_.back() == '/') root_.pop_back();
+    return allocBuffers();
+}
+
+std::vector<std::string> SdRomReader::listRoms(const std::string &dir) {
+    std::vector<std::string> result;
+    DIR* d = opendir((root_ + dir).c_str());
+    if (!d) return result;
+    while (dirent* e = readdir(d)) {
+        std::string name = e->d_name;
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, ".gb") == 0) {
+            result.push_back(dir + (dir.back() == '/' ? "" : "/") + name);
+        }
+    }
+    closedir(d);
+    return result;
+}
+
+bool SdRomReader::open(const std::string &path) {
+    close();
+    file_ = std::fopen((root_ + path).c_str(), "rb");
+    if (!file_) return false;
+    std::fseek(file_, 0, SEEK_END);
+    size_ = static_cast<size_t>(std::ftell(file_));
+    for (Buffer &buf : buffers_) buf.block = -1;
+    opened_ = true;
+    return true;
+}
+
+void SdRomReader::close() {
+    if (!opened_) return;
+    std::fclose(file_);
+    file_ = nullptr;
+    opened_ = false;
+    size_ = 0;
+}
+
+// Linux 版は先読みしない
+void SdRomReader::requestPrefetch(int, int32_t) {}
+#endif
+
+bool SdRomReader::loadBlock(Buffer &buf, int32_t block) {
+    uint32_t start = static_cast<uint32_t>(block) * BLOCK_SIZE;
+    if (start >= size_) return false;
+    size_t len = size_ - start < BLOCK_SIZE ? size_ - start : BLOCK_SIZE;
+#ifdef ARDUINO
+    file_.seek(start, SeekSet);
+    size_t n = file_.read(buf.data, len);
+#else
+    std::fseek(file_, start, SEEK_SET);
+    size_t n = std::fread(buf.data, 1, len, file_);
+#endif
+    buf.block = n == len ? block : -1;
+    buf.length = n;
+    return n == len;
+}
+
+size_t SdRomReader::read(uint32_t offset, uint8_t* dst, size_t len) {
+    if (!opened_ || offset >= size_) return 0;
+    if (len > size_ - offset) len = size_ - offset;
+
+    size_t done = 0;
+    while (done < len) {
+        uint32_t pos = offset + done;
+        int32_t block = pos / BLOCK_SIZE;
+        size_t inBlock = pos % BLOCK_SIZE;
+
+#ifdef ARDUINO
+        // 先読み中のブロックならここで読み込み完了を待つことになる
+        xSemaphoreTake(ioMutex_, portMAX_DELAY);
+#endif
+        int slot = buffers_[0].block == block ? 0 : (buffers_[1].block == block ? 1 : -1);
+        if (slot >= 0) {
+            stats_.bufferHits++;
+        } else {
+            // 次ブロック用に取っておく方ではない面に同期で読む
+            slot = buffers_[0].block == block + 1 ? 1 : 0;
+            if (!loadBlock(buffers_[slot], block)) {
+#ifdef ARDUINO
+                xSemaphoreGive(ioMutex_);
+#endif
+                break;
+            }
+            stats_.syncLoads++;
+        }
+
+        const Buffer &buf = buffers_[slot];
+        size_t n = buf.length - inBlock;
+        if (n > len - done) n = len - done;
+        std::memcpy(dst + done, buf.data + inBlock, n);
+        done += n;
+
+        // もう一方の面に次のブロックを先読み
+        int other = slot ^ 1;
+        bool wantNext = (block + 1) * BLOCK_SIZE < size_ && buffers_[other].block != block + 1;
+        if (wantNext) buffers_[other].block = -1;
+#ifdef ARDUINO
+        xSemaphoreGive(ioMutex_);
+#endif
+        if (wantNext) requestPrefetch(other, block + 1);
+    }
+    return done;
+}
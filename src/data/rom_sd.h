@@ -0,0 +1,89 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include "data/rom_source.h"
+
+#ifdef ARDUINO
+#include <SPI.h>
+#include <SD.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#else
+#include <cstdio>
+#endif
+
+/**
+ * @brief SD カード上の ROM をブロック単位で読むリーダー（ダブルバッファ）
+ *
+ * 4KB 境界に揃えたブロックを2面のバッファに読み込む。ブロック n を返したら
+ * ブロック n+1 を裏のバッファへ読み込み始めるので、呼び出し側が n を処理して
+ * いる間に次の読み込みが進む（ESP32 では読み込み専用タスクで行う）。
+ * Linux では begin() に渡したディレクトリを SD カードのルートとして扱い、
+ * 先読みはせず同期で読む。
+ */
+class SdRomReader : public RomSource {
+public:
+    static constexpr size_t BLOCK_SIZE = 4096;
+
+    struct Stats {
+        uint32_t bufferHits = 0;    // どちらかのバッファにあった
+        uint32_t syncLoads = 0;     // 読み出し時に待って読んだ
+        uint32_t prefetches = 0;    // 裏で先読みしたブロック数
+    };
+
+    SdRomReader() = default;
+    ~SdRomReader() override;
+    SdRomReader(const SdRomReader&) = delete;
+    SdRomReader& operator=(const SdRomReader&) = delete;
+
+#ifdef ARDUINO
+    bool begin(SPIClass &spi, uint8_t csPin, uint32_t frequency = 20000000);
+#else
+    bool begin(const std::string &rootDir);
+#endif
+    // dir 直下の .gb ファイル一覧
+    std::vector<std::string> listRoms(const std::string &dir);
+
+    bool open(const std::string &path) override;
+    void close() override;
+    bool isOpen() const { return opened_; }
+    size_t size() const override { return size_; }
+
+    size_t read(uint32_t offset, uint8_t* dst, size_t len) override;
+
+    const Stats& stats() const { return stats_; }
+    void resetStats() { stats_ = Stats(); }
+
+private:
+    struct Buffer {
+        uint8_t* data = nullptr;
+        int32_t block = -1;    // 保持しているブロック番号（-1: 空）
+        size_t length = 0;
+    };
+
+    bool allocBuffers();
+    bool loadBlock(Buffer &buf, int32_t block);  // ioMutex_ を持った状態で呼ぶ
+    void requestPrefetch(int slot, int32_t block);
+
+    Buffer buffers_[2];
+    size_t size_ = 0;
+    bool opened_ = false;
+    Stats stats_;
+
+#ifdef ARDUINO
+    static void taskEntry(void* arg);
+    void run();
+
+    File file_;
+    SemaphoreHandle_t ioMutex_ = nullptr;  // ファイルとバッファ状態を守る
+    TaskHandle_t task_ = nullptr;
+    volatile int32_t pendingBlock_ = -1;
+    volatile int pendingSlot_ = 0;
+#else
+    std::string root_;
+    FILE* file_ = nullptr;
+#endif
+};
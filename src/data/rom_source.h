@@ -0,0 +1,23 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+/**
+ * @brief RomImage の下に差し込む ROM の読み出し元
+ *
+ * SD カード（SdRomReader）や圧縮 ROM コンテナ（PackedRomReader）など、
+ * ファイルをそのまま読むのではない読み出し元が実装する。
+ * read() は RomImage のロック内から呼ばれる。
+ */
+class RomSource {
+public:
+    virtual ~RomSource() = default;
+
+    virtual bool open(const std::string &path) = 0;
+    virtual void close() = 0;
+    // 展開後の ROM サイズ
+    virtual size_t size() const = 0;
+    // 絶対オフセットから len バイト読む。戻り値は実際に読めたバイト数
+    virtual size_t read(uint32_t offset, uint8_t* dst, size_t len) = 0;
+};
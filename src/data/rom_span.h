@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief ROM データを指す所有しないビュー（ポインタ + 長さ）
+ *
+ * マップ済み ROM を直接指すか、呼び出し側の scratch バッファを指す。
+ * 指す先の寿命は呼び出し側が管理する。
+ */
+struct RomSpan {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+    RomSpan() = default;
+    RomSpan(const uint8_t* d, size_t n) : data(d), size(n) {}
+
+    explicit operator bool() const { return data != nullptr; }
+    bool empty() const { return size == 0; }
+    const uint8_t* begin() const { return data; }
+    const uint8_t* end() const { return data + size; }
+    uint8_t operator[](size_t i) const { return data[i]; }
+
+    // 範囲外は切り詰める
+    RomSpan sub(size_t offset, size_t len) const {
+        if (offset > size) offset = size;
+        if (len > size - offset) len = size - offset;
+        return RomSpan(data + offset, len);
+    }
+    // リトルエンディアン16bit（範囲外は0）
+    uint16_t le16(size_t offset) const {
+        if (offset + 1 >= size) return 0;
+        return data[offset] | (data[offset + 1] << 8);
+    }
+};
@@ -1,44 +1,19 @@
-#include <Arduino.h>
-#include <LittleFS.h>
-#include <vector>
+#include "data/rom_util.h"
+#include "data/data_log.h"
+#include <stdexcept>
 // --- ROM からバイナリ取得 ---
-std::vector<uint8_t> readROMData(const std::string &path, uint32_t startAddr, size_t maxLength, const std::vector<uint8_t>& stopSequence = {}) {
+std::vector<uint8_t> readROMData(RomImage &rom, uint32_t startAddr, size_t maxLength, const std::vector<uint8_t>& stopSequence) {
     std::vector<uint8_t> result;
 
-    File rom = LittleFS.open(path.c_str(), "r");
-    if (!rom) {
-        Serial.println("ROM ファイル開けません");
+    if (!rom.isOpen()) {
+        DATA_LOG("ROM ファイル開けません\n");
         return result;
     }
 
-    rom.seek(startAddr, SeekSet);
-
-    size_t readCount = 0;
-    std::vector<uint8_t> buffer;
-
-    while (readCount < maxLength && rom.available()) {
-        uint8_t byte = rom.read();
-        result.push_back(byte);
-        readCount++;
-
-        //Serial.print("ROM byte: 0x");
-        //Serial.println(byte, HEX); // デバッグ出力
-
-        if (!stopSequence.empty()) {
-            buffer.push_back(byte);
-            if (buffer.size() > stopSequence.size()) buffer.erase(buffer.begin());
-
-            if (buffer.size() == stopSequence.size()) {
-                bool match = true;
-                for (size_t i = 0; i < stopSequence.size(); i++) {
-                    if (buffer[i] != stopSequence[i]) { match = false; break; }
-                }
-                if (match) break;
-            }
-        }
-    }
-
-    rom.close();
+    result.resize(maxLength);
+    size_t readCount = rom.readUntil(startAddr, result.data(), maxLength,
+                                     stopSequence.data(), stopSequence.size());
+    result.resize(readCount);
     return result;
 }
 
@@ -1,6 +1,8 @@
 #pragma once
-#include <Arduino.h>
-#include<vector>
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "data/rom_image.h"
 
-std::vector<uint8_t> readROMData(const std::string &path, uint32_t startAddr, size_t maxLength, const std::vector<uint8_t>& stopSequence = {});
-uint16_t readLittleEndian16(const std::vector<uint8_t>& data, size_t offset);
\ No newline at end of file
+std::vector<uint8_t> readROMData(RomImage &rom, uint32_t startAddr, size_t maxLength, const std::vector<uint8_t>& stopSequence = {});
+uint16_t readLittleEndian16(const std::vector<uint8_t>& data, size_t offset);
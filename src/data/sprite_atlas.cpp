@@ -0,0 +1,125 @@
+#include "data/sprite_atlas.h"
+#include "data/pokemon_sprite.h"
+#include <cstring>
+
+// --- アトラス作成 ---
+// ヘッダと表は最後に書き直す（途中で電源が落ちてもマジックが無いので読まれない）
+bool SpriteAtlas::build(RomImage &rom, const RomIndex &index, const std::string &path) {
+    FileHeader header = {};
+    Entry entries[MAX_DEX + 1] = {};
+    const uint32_t dataStart = sizeof(FileHeader) + sizeof(Entry) * MAX_DEX;
+
+#ifdef ARDUINO
+    File f = LittleFS.open(path.c_str(), "w");
+    if (!f) return false;
+    auto writeBytes = [&](const void* src, size_t len) {
+        return f.write(static_cast<const uint8_t*>(src), len) == len;
+    };
+    auto seekTo = [&](uint32_t pos) { return f.seek(pos, SeekSet); };
+#else
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    auto writeBytes = [&](const void* src, size_t len) { return std::fwrite(src, 1, len, f) == len; };
+    auto seekTo = [&](uint32_t pos) { return std::fseek(f, pos, SEEK_SET) == 0; };
+#endif
+
+    bool ok = writeBytes(&header, sizeof(header)) && writeBytes(&entries[1], sizeof(Entry) * MAX_DEX);
+
+    uint8_t sprite[PicDecoder::OUTPUT_MAX];
+    PicDecoder::Scratch scratch;
+    PicDecoder decoder(scratch);
+    uint32_t offset = dataStart;
+    for (uint8_t dex = 1; ok && dex <= MAX_DEX; dex++) {
+        const PokemonLocation* loc = index.find(dex);
+        if (!loc) continue;
+        int size = decodePokemonSprite(rom, *loc, decoder, sprite, sizeof(sprite));
+        int width = 0, height = 0;
+        if (size <= 0 || !spriteSizeFromOutput(size, width, height)) continue;  // 失敗は size 0 のまま
+        ok = writeBytes(sprite, size);
+        entries[dex].offset = offset;
+        entries[dex].size = size;
+        entries[dex].width = width;
+        entries[dex].height = height;
+        offset += size;
+    }
+
+    std::memcpy(header.magic, "SPAT", 4);
+    header.version = VERSION;
+    header.headerChecksum = index.key().headerChecksum;
+    header.count = MAX_DEX;
+    header.globalChecksum = index.key().globalChecksum;
+    header.entrySize = sizeof(Entry);
+    ok = ok && seekTo(0) && writeBytes(&header, sizeof(header)) &&
+         writeBytes(&entries[1], sizeof(Entry) * MAX_DEX);
+
+#ifdef ARDUINO
+    f.close();
+#else
+    std::fclose(f);
+#endif
+    return ok;
+}
+
+// --- 読み出し ---
+SpriteAtlas::~SpriteAtlas() {
+    close();
+#ifdef ARDUINO
+    if (mutex_) vSemaphoreDelete(mutex_);
+#endif
+}
+
+bool SpriteAtlas::open(const std::string &path, const RomIndexKey &key) {
+    close();
+#ifdef ARDUINO
+    if (!mutex_) mutex_ = xSemaphoreCreateMutex();
+    if (!mutex_) return false;
+    file_ = LittleFS.open(path.c_str(), "r");
+    if (!file_) return false;
+    auto readBytes = [&](void* dst, size_t len) { return file_.read(static_cast<uint8_t*>(dst), len) == len; };
+#else
+    file_ = std::fopen(path.c_str(), "rb");
+    if (!file_) return false;
+    auto readBytes = [&](void* dst, size_t len) { return std::fread(dst, 1, len, file_) == len; };
+#endif
+
+    FileHeader header;
+    valid_ = readBytes(&header, sizeof(header)) &&
+             std::memcmp(header.magic, "SPAT", 4) == 0 &&
+             header.version == VERSION &&
+             header.entrySize == sizeof(Entry) &&
+             header.count == MAX_DEX &&
+             header.headerChecksum == key.headerChecksum &&
+             header.globalChecksum == key.globalChecksum &&
+             readBytes(&entries_[1], sizeof(Entry) * MAX_DEX);
+    if (!valid_) close();
+    return valid_;
+}
+
+void SpriteAtlas::close() {
+#ifdef ARDUINO
+    if (file_) file_.close();
+#else
+    if (file_) std::fclose(file_);
+    file_ = nullptr;
+#endif
+    valid_ = false;
+}
+
+size_t SpriteAtlas::read(uint8_t dex_id, uint8_t* dst, size_t cap, int &width, int &height) {
+    if (!valid_ || dex_id == 0 || dex_id > MAX_DEX) return 0;
+    const Entry &e = entries_[dex_id];
+    if (e.size == 0 || e.size > cap) return 0;
+
+#ifdef ARDUINO
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    bool ok = file_.seek(e.offset, SeekSet) && file_.read(dst, e.size) == e.size;
+    xSemaphoreGive(mutex_);
+#else
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool ok = std::fseek(file_, e.offset, SEEK_SET) == 0 && std::fread(dst, 1, e.size, file_) == e.size;
+#endif
+    if (!ok) return 0;
+    width = e.width;
+    height = e.height;
+    return e.size;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include "data/rom_image.h"
+#include "data/rom_index.h"
+
+#ifdef ARDUINO
+#include <LittleFS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#else
+#include <cstdio>
+#include <mutex>
+#endif
+
+/**
+ * @brief 151 匹分の展開済みスプライト（2bpp・スキャンライン順）をまとめたファイル
+ *
+ * 初回起動時に ROM から全スプライトを展開して書き出し、以降は表示のたびに
+ * 展開せず1回の読み出しで済ませる。ROM のチェックサム（RomIndexKey）が
+ * 一致しないファイルは使わない。
+ *
+ *   FileHeader
+ *   Entry[151]        // Dex 1～151。size == 0 は展開失敗
+ *   スプライトデータ
+ */
+class SpriteAtlas {
+public:
+    static constexpr uint8_t MAX_DEX = RomIndex::MAX_DEX;
+
+    // ROM から全スプライトを展開して path に書き出す
+    static bool build(RomImage &rom, const RomIndex &index, const std::string &path);
+
+    SpriteAtlas() = default;
+    ~SpriteAtlas();
+    SpriteAtlas(const SpriteAtlas&) = delete;
+    SpriteAtlas& operator=(const SpriteAtlas&) = delete;
+
+    // ファイルを開いてオフセット表を読み込む（キー不一致・破損時は false）
+    bool open(const std::string &path, const RomIndexKey &key);
+    void close();
+    bool valid() const { return valid_; }
+
+    // Dex番号のスプライトを dst に読む。戻り値はバイト数（無ければ 0）
+    // 複数タスクから呼んでよい
+    size_t read(uint8_t dex_id, uint8_t* dst, size_t cap, int &width, int &height);
+
+private:
+    struct FileHeader {
+        char     magic[4];
+        uint16_t version;
+        uint8_t  headerChecksum;
+        uint8_t  count;
+        uint16_t globalChecksum;
+        uint16_t entrySize;
+    };
+    struct Entry {
+        uint32_t offset;   // ファイル先頭から
+        uint16_t size;
+        uint8_t  width;    // ピクセル
+        uint8_t  height;
+    };
+    static constexpr uint16_t VERSION = 1;
+
+    Entry entries_[MAX_DEX + 1] = {};
+    bool valid_ = false;
+#ifdef ARDUINO
+    File file_;
+    SemaphoreHandle_t mutex_ = nullptr;
+#else
+    FILE* file_ = nullptr;
+    std::mutex mutex_;
+#endif
+};
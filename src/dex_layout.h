@@ -0,0 +1,60 @@
+#pragma once
+#include <algorithm>
+#include <stdint.h>
+#include "data/PicUncompress.h"
+#include "render/text_layout.h"
+
+// 図鑑画面の配置。描画関数（main.cpp）と RenderEngine の領域の矩形はどちらもここから決める。
+// 文字はマップの枠の内側の空白に収まる文字数・行数にしてあり、それを超えた分は描かない
+static const TextBox numberText = { 170, 2, 2, 2, 3, 1, false };   // 図鑑番号（数字なので上文字の段は無い）
+static const TextBox nameText = { 170, 32, 2, 2, 8, 1, true };
+static const TextBox typeText = { 182, 78, 1, 2, 5, 1, true };     // 分類名
+static const TextBox typeSuffixText = { 218, 78, 1, 2, 4, 1, true };  // 「ポケモン」（分類名が長ければその後ろにずらす）
+static const TextBox heightText = { 182, 96, 1, 2, 4, 1, true };
+static const TextBox weightText = { 182, 112, 1, 2, 5, 1, true };
+static const TextBox dexText = { 20, 156, 1, 2, 29, 4, true };     // 図鑑説明文
+static const int UNIT_X = 220;       // 高さ・重さの単位のタイル（数字がここまで伸びたら数字のすぐ後ろ）
+static const int SPRITE_X = 10;      // スプライトの左上（scale 前の値。draw2bpp_color と同じ）
+static const int SPRITE_Y = 10;
+static const int SPRITE_SCALE = 2;
+static const int SPRITE_SIZE = PicDecoder::MAX_TILES * 8;
+
+// 分類名が typeEnd（次の文字を置く x）まで伸びたときの「ポケモン」の枠
+inline TextBox typeSuffixBox(int typeEnd) {
+    TextBox box = typeSuffixText;
+    if (typeEnd > box.x) box.x = typeEnd;
+    return box;
+}
+
+// 数字を penX（次の文字を置く x）まで描いたときの、後ろの単位のタイルの x
+inline int unitX(const TextBox &box, int penX) {
+    return std::max(UNIT_X, penX - box.spacing);
+}
+
+// 領域の矩形（その描画関数が描きうる範囲をすべて含む）
+struct DexRect {
+    int16_t x, y, w, h;
+};
+
+inline DexRect textRect(const TextBox &box, int right) {
+    return { box.left(), box.top(), static_cast<int16_t>(right - box.left()), box.height() };
+}
+
+inline DexRect numberRect() { return textRect(numberText, numberText.right()); }
+inline DexRect nameRect() { return textRect(nameText, nameText.right()); }
+inline DexRect spriteRect() {
+    const int16_t size = SPRITE_SIZE * SPRITE_SCALE;
+    return { SPRITE_X * SPRITE_SCALE, SPRITE_Y * SPRITE_SCALE, size, size };
+}
+// 分類名が typeText いっぱいのとき「ポケモン」が一番右に来る
+inline DexRect typeRect() {
+    return textRect(typeText, typeSuffixBox(typeText.x + typeText.columns * typeText.advance()).right());
+}
+// 単位のタイルは "m" が 1 枚、"kg" が 2 枚
+inline DexRect heightRect() {
+    return textRect(heightText, unitX(heightText, heightText.right() + heightText.spacing) + 8);
+}
+inline DexRect weightRect() {
+    return textRect(weightText, unitX(weightText, weightText.right() + weightText.spacing) + 16);
+}
+inline DexRect dexTextRect() { return textRect(dexText, dexText.right()); }
@@ -1,5 +1,4 @@
 #include <Arduino.h>
-#include <LittleFS.h>
 #include <TFT_eSPI.h>
 #include <map>
 #include "font_util.h"
@@ -220,7 +219,7 @@ static const std::map<uint8_t, FontInfo> fontTable = {
 
 
 // --- 上文字＋ベース文字描画（デバッグ入り） ---
-void drawKanaStacked(TFT_eSPI &tft, const std::string &romPath, uint8_t code, int x, int y, uint16_t color = TFT_WHITE, uint16_t bg = TFT_BLACK, uint8_t scale) {
+void drawKanaStacked(TFT_eSPI &tft, RomImage &rom, uint8_t code, int x, int y, uint16_t color = TFT_WHITE, uint16_t bg = TFT_BLACK, uint8_t scale) {
     auto it = fontTable.find(code);
     if (it == fontTable.end()) {
         Serial.print("FontTable に存在しないコード: 0x");
@@ -234,47 +233,49 @@ void drawKanaStacked(TFT_eSPI &tft, const std::string &romPath, uint8_t code, in
     Serial.print(", accent: 0x"); Serial.println(info.accentAddress, HEX);
 
     uint8_t buf[8];
-    File rom = LittleFS.open(romPath.c_str(), "r");
-    if (!rom) {
+    if (!rom.isOpen()) {
         Serial.println("ROM ファイル開けません(drawKanaStacked)");
         return;
     }
 
-    // 上文字
+    // 上文字（マップ済みROMならコピーせず直接参照）
     if (info.accentAddress != 0) {
-        rom.seek(info.accentAddress, SeekSet);
-        if (rom.read(buf, 8) == 8) {
+        RomSpan glyph = rom.view(info.accentAddress, 8, buf);
+        if (glyph.size == 8) {
             Serial.println("上文字描画");
-            drawFont8x8(tft, x, y, buf, color, bg, scale);
+            drawFont8x8(tft, x, y, glyph.data, color, bg, scale);
         } else {
             Serial.println("上文字読み込み失敗");
         }
     }
 
     // ベース文字
-    rom.seek(info.baseAddress, SeekSet);
-    if (rom.read(buf, 8) == 8) {
+    RomSpan glyph = rom.view(info.baseAddress, 8, buf);
+    if (glyph.size == 8) {
         Serial.println("ベース文字描画");
-        drawFont8x8(tft, x, y + 8*scale, buf, color, bg, scale);
+        drawFont8x8(tft, x, y + 8*scale, glyph.data, color, bg, scale);
     } else {
         Serial.println("ベース文字読み込み失敗");
     }
-
-    rom.close();
 }
 
 // --- バイナリ配列描画 ---
-void drawBinaryString(TFT_eSPI &tft, const std::vector<uint8_t>& data, int startX, int startY, int spacing, uint8_t scale, const std::string &romPath) {
+void drawBinaryString(TFT_eSPI &tft, const uint8_t* data, size_t length, int startX, int startY, int spacing, uint8_t scale, RomImage &rom) {
     int x = startX;
     int y = startY;
 
-    for (auto code : data) {
+    for (size_t i = 0; i < length; i++) {
+        uint8_t code = data[i];
         if (code == 0x4E || code == 0x4F) { x = startX; y += 16*scale + spacing; continue; }
         if (code == 0x7F) { x += 8*scale + spacing; continue;}
 
-        drawKanaStacked(tft, romPath, code, x, y, textColor, bgColor, scale);
+        drawKanaStacked(tft, rom, code, x, y, textColor, bgColor, scale);
         x += 8*scale + spacing;
 
         if (x + 8*scale > tft.width()) { x = startX; y += 16*scale + spacing; }
     }
 }
+
+void drawBinaryString(TFT_eSPI &tft, const std::vector<uint8_t>& data, int startX, int startY, int spacing, uint8_t scale, RomImage &rom) {
+    drawBinaryString(tft, data.data(), data.size(), startX, startY, spacing, scale, rom);
+}
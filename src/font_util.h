@@ -3,11 +3,13 @@
 #include <map>
 #include <stdint.h>
 #include <Vector>
+#include "data/rom_image.h"
 
 extern uint16_t textColor;
 extern uint16_t bgColor;
 static const std::map<uint8_t, FontInfo> fontTable;
 
-void drawFont8x8(TFT_eSPI &tft, int x, int y, uint8_t buf[8], uint16_t color, uint16_t bg, uint8_t scale);
-void drawKanaStacked(TFT_eSPI &tft, const std::string &romPath, uint8_t code, int x, int y, uint16_t color = TFT_WHITE, uint16_t bg = TFT_BLACK, uint8_t scale = 2);
-void drawBinaryString(TFT_eSPI &tft, const std::vector<uint8_t>& data, int startX, int startY, int spacing, uint8_t scale, const std::string &romPath);
+void drawFont8x8(TFT_eSPI &tft, int x, int y, const uint8_t buf[8], uint16_t color, uint16_t bg, uint8_t scale);
+void drawKanaStacked(TFT_eSPI &tft, RomImage &rom, uint8_t code, int x, int y, uint16_t color = TFT_WHITE, uint16_t bg = TFT_BLACK, uint8_t scale = 2);
+void drawBinaryString(TFT_eSPI &tft, const uint8_t* data, size_t length, int startX, int startY, int spacing, uint8_t scale, RomImage &rom);
+void drawBinaryString(TFT_eSPI &tft, const std::vector<uint8_t>& data, int startX, int startY, int spacing, uint8_t scale, RomImage &rom);
@@ -5,14 +5,30 @@
 #include <string>
 #include <Wire.h>
 #include <Adafruit_MCP23X17.h>
+#include "data/rom_image.h"
+#include "data/rom_sd.h"
+#include "data/rom_pack.h"
 #include "data/rom_util.h"
+#include "data/rom_index.h"
+#include "data/rom_profile.h"
+#include "data/dex_prefetch.h"
+#include "data/sprite_atlas.h"
 #include "data/PicUncompress.h"
 #include "data/pokemon_util.h"
 #include "data/SpriteImage.h"
 #include "map_draw.h" 
+#include "dex_layout.h"
+#include "render/lcd_dma.h"
+#include "render/frame_compose.h"
+#include "render/render.h"
+#include "render/glyph.h"
+#include "render/text_layout.h"
 #include "font_table.h"  // fontTable が定義されている
 
 TFT_eSPI tft = TFT_eSPI();
+LcdDma lcdDma;  // スプライト・マップ・文字の DMA 転送（ピンポンバッファ）
+FrameComposer frameComposer;  // オフスクリーン合成と差分転送（PSRAM があるときだけ）
+RenderEngine renderEngine;  // 図鑑画面の領域ごとの描き直し
 Adafruit_MCP23X17 mcp;
 
 // ボタン接続
@@ -26,10 +42,38 @@ std::vector<uint8_t> index_to_dex;
 std::vector<int> dex_to_index;
 std::map<std::string, uint8_t> string2Byte;
 
-//呼び出すロム情報
+//呼び出すロム情報（LittleFS。partitions_rom.csv の 1MB の LittleFS には入らないので、既定のテーブル用）
 const std::string romPath = "/pokemon_blue.gb";
-
-//ポケモン図鑑の表示するDex番号
+// ROM を書き込んだデータパーティションのラベル（partitions_rom.csv）
+const std::string romPartition = "rom";
+// SD カード上の ROM（HSPI: SCK=12, MISO=14, MOSI=27, CS=16）
+SPIClass spiSD(HSPI);
+const int sdCsPin = 16;
+const std::string romSdPath = "/roms/pokemon_blue.gb";
+SdRomReader sdRom;
+// ブロック圧縮した ROM（tools/rom_pack で作成）。生の ROM より先に探す
+const std::string romPackPath = "/pokemon_blue.rpk";
+PackedRomReader packedRom(4);  // 展開済みブロック 4 x 4KB
+// ROMはセッション中1度だけ開いて使い回す
+RomImage romImage;
+// ROM の識別結果キャッシュ（CRC32 を毎回計算しない）
+const std::string romIdPath = "/rom_id.bin";
+// 起動時にヘッダから選んだ ROM バリアントのアドレス表
+const RomProfile* romProfile = nullptr;
+// ROM の索引ファイル（初回起動時に作成）
+const std::string indexPath = "/pokemon_blue.idx";
+RomIndex romIndex;
+// 展開済みスプライト 151 匹分（初回起動時に作成）
+const std::string atlasPath = "/pokemon_blue.spr";
+SpriteAtlas spriteAtlas;
+// 隣の図鑑エントリを表示しないコア(0)で先読み
+DexPrefetcher dexPrefetcher;
+// ROM ページキャッシュ設定（Serial の 's' で統計を見てサイズを決める）
+const size_t romCachePageSize  = 256;
+const size_t romCachePageCount = 32;
+const bool   romCacheUsePsram  = false;
+
+//ポケモン図鑑の表示するDex番号（1～151）。ボタンで変わり、ベンチマーク後の再表示にも使う
 static uint8_t dex_id = 1; 
 
 // フォントの色設定　白地（背景）に黒文字
@@ -38,10 +82,10 @@ uint16_t bgColor   = TFT_WHITE;   // 背景の色
 
 
 // 文字 → バイナリ値 の逆引きテーブル
-static std::map<std::string, uint8_t> BuildChar2ByteTable() {
+static std::map<std::string, uint8_t> BuildChar2ByteTable(const std::map<uint8_t, FontInfo>& charset) {
     std::map<std::string, uint8_t> reverse;
 
-    for (const auto& pair : fontTable) {
+    for (const auto& pair : charset) {
         uint8_t code = pair.first;           // キー
         const FontInfo& info = pair.second;  // 値
         reverse[info.character] = code;
@@ -50,25 +94,12 @@ static std::map<std::string, uint8_t> BuildChar2ByteTable() {
 }
 
 
-// --- 8x8 フォント描画 ---
-void drawFont8x8(TFT_eSPI &tft, int x, int y, uint8_t buf[8], uint16_t color, uint16_t bg, uint8_t scale) {
-    for (int row = 0; row < 8; row++) {
-        for (int col = 0; col < 8; col++) {
-            bool bit = (buf[row] >> (7 - col)) & 1;
-            uint16_t c = bit ? color : bg;
-            if (scale == 1) {
-                tft.drawPixel(x + col, y + row, c);
-            } else {
-                tft.fillRect(x + col*scale, y + row*scale, scale, scale, c);
-            }
-        }
-    }
-}
-
 // --- 上文字＋ベース文字描画（デバッグ入り） ---
-void drawKanaStacked(TFT_eSPI &tft, const std::string &romPath, uint8_t code, int x, int y, uint16_t color = TFT_WHITE, uint16_t bg = TFT_BLACK, uint8_t scale = 2) {
-    auto it = fontTable.find(code);
-    if (it == fontTable.end()) {
+// accent が false なら上文字の段は描かない（ベース文字だけ (x, y + 8*scale) に描く）
+void drawKanaStacked(TFT_eSPI &tft, RomImage &rom, uint8_t code, int x, int y, uint16_t color = TFT_WHITE, uint16_t bg = TFT_BLACK, uint8_t scale = 2, bool accent = true) {
+    const std::map<uint8_t, FontInfo>& charset = *romProfile->charset;
+    auto it = charset.find(code);
+    if (it == charset.end()) {
         Serial.print("FontTable に存在しないコード: 0x");
         Serial.println(code, HEX);
         return;
@@ -80,50 +111,52 @@ void drawKanaStacked(TFT_eSPI &tft, const std::string &romPath, uint8_t code, in
     Serial.print(", accent: 0x"); Serial.println(info.accentAddress, HEX);
 
     uint8_t buf[8];
-    File rom = LittleFS.open(romPath.c_str(), "r");
-    if (!rom) {
+    if (!rom.isOpen()) {
         Serial.println("ROM ファイル開けません(drawKanaStacked)");
         return;
     }
 
-    // 上文字
-    if (info.accentAddress != 0) {
-        rom.seek(info.accentAddress, SeekSet);
-        if (rom.read(buf, 8) == 8) {
+    // 上文字（マップ済みROMならコピーせず直接参照）
+    if (accent && info.accentAddress != 0) {
+        RomSpan glyph = rom.view(info.accentAddress, 8, buf);
+        if (glyph.size == 8) {
             Serial.println("上文字描画");
-            drawFont8x8(tft, x, y, buf, color, bg, scale);
+            drawFont8x8(tft, x, y, glyph.data, color, bg, scale);
         } else {
             Serial.println("上文字読み込み失敗");
         }
     }
 
     // ベース文字
-    rom.seek(info.baseAddress, SeekSet);
-    if (rom.read(buf, 8) == 8) {
+    RomSpan glyph = rom.view(info.baseAddress, 8, buf);
+    if (glyph.size == 8) {
         Serial.println("ベース文字描画");
-        drawFont8x8(tft, x, y + 8*scale, buf, color, bg, scale);
+        drawFont8x8(tft, x, y + 8*scale, glyph.data, color, bg, scale);
     } else {
         Serial.println("ベース文字読み込み失敗");
     }
-
-    rom.close();
 }
 
 
 // --- バイナリ配列描画 ---
-void drawBinaryString(TFT_eSPI &tft, const std::vector<uint8_t>& data, int startX, int startY, int spacing, uint8_t scale, const std::string &romPath) {
-    int x = startX;
-    int y = startY;
-
-    for (auto code : data) {
-        if (code == 0x4E || code == 0x4F) { x = startX; y += 16*scale + spacing; continue; }
-        if (code == 0x7F) { x += 8*scale + spacing; continue;}
-
-        drawKanaStacked(tft, romPath, code, x, y, textColor, bgColor, scale);
-        x += 8*scale + spacing;
-
-        if (x + 8*scale > tft.width()) { x = startX; y += 16*scale + spacing; }
+// box の升目に並べて描く。box に入らない文字は描かない。戻り値は次の文字を置く x
+int drawBinaryString(TFT_eSPI &tft, const uint8_t* data, size_t length, const TextBox &box, RomImage &rom) {
+    TextCursor cursor(box);
+    // 文字列の間は SPI を持ったままにし、前の文字の転送中に次の文字を展開する
+    lcdDma.beginBatch();
+
+    for (size_t i = 0; i < length && !cursor.full(); i++) {
+        int x, y;
+        if (cursor.place(data[i], x, y)) {
+            drawKanaStacked(tft, rom, data[i], x, y, textColor, bgColor, box.scale, box.accents);
+        }
     }
+    lcdDma.endBatch();
+    return cursor.x();
+}
+
+int drawBinaryString(TFT_eSPI &tft, const std::vector<uint8_t>& data, const TextBox &box, RomImage &rom) {
+    return drawBinaryString(tft, data.data(), data.size(), box, rom);
 }
 
 
@@ -171,7 +204,7 @@ std::vector<uint8_t> convertStringToCodes(
 void buildTileSet() {
     // タイルデータの読み込み
     std::vector<uint8_t> tileset_buf =
-        readROMData(romPath, 0x12881, 320, {});
+        readROMData(romImage, romProfile->mapTileset, romProfile->mapTilesetLength, {});
         
     for (size_t i=0; i + 16 <= tileset_buf.size(); i += 16) {
         uint8_t* tile = new uint8_t[16];
@@ -180,80 +213,420 @@ void buildTileSet() {
     }
 }
 
-/**
- * @brief Dex番号を指定してポケモンの名前・図鑑情報・圧縮スプライトを取得して描画する
- * 
- * @param romPath ROMファイルパス
- * @param tft TFTディスプレイオブジェクト
- * @param dex_id Dex番号（0始まり）
- */
-
-void displayPokemonInfo(const std::string &romPath, TFT_eSPI &tft, uint8_t dex_id,
-                        const std::vector<int> &dex_to_index) {
-    
-    // マップ描画
+// --- 図鑑画面の領域 ---
+// 領域の描画関数が参照する、表示中の 1 画面分
+struct DexScreenView {
+    RomImage* rom;
+    TFT_eSPI* tft;
+    const DexScreenData* data;
+    uint8_t dex_id;
+};
+static DexScreenView dexView = { nullptr, nullptr, nullptr, 0 };
+
+static int regionFrame = -1;
+static int regionNumber = -1;
+static int regionName = -1;
+static int regionSprite = -1;
+static int regionType = -1;
+static int regionHeight = -1;
+static int regionWeight = -1;
+static int regionText = -1;
+
+static void drawFrameRegion(void*) {
     drawMap();
-    bgColor = tft.color565(248, 232, 248); // fontの背景色をポケモンの色パレットに合わせる。
-    
-    // ポケモン名前取得
-    std::vector<uint8_t> pokename = getPokemonName(romPath, dex_id, dex_to_index);
-    // ポケモン名前表示
-    drawBinaryString(tft, pokename, 170, 32, 2, 2, romPath);
-    // ポケモン図鑑番号表示
-    std::string str_dex_id = std::to_string(static_cast<unsigned int>(dex_id));
-    drawBinaryString(tft, convertStringToCodes(str_dex_id, string2Byte), 170, 2, 2, 2, romPath);
-
-    // スプライト取得
-    std::vector<uint8_t> compressed_sprite = getCompressedPokemonSprite(romPath, dex_id, dex_to_index);
-    // カラーパレット取得
-    std::vector<uint16_t> palette=getPokemonColorPalette(romPath,dex_id);
-    // スプライト表示
-    displaySpriteImageColor(compressed_sprite,palette.data());
-
-    // 図鑑詳細取得
-    std::vector<uint8_t> dex_detail;
-    std::vector<uint8_t> poke_information_type;
-    std::vector<uint8_t> height_weight;
-
-    //getPokemonDexDetail(romPath, dex_id, dex_to_index, dex_detail, poke_information_type);
-    getPokemonDexDetailFull(romPath, dex_id, dex_to_index, dex_detail, poke_information_type,height_weight);
- 
-    //ポケモンの種族名　〇〇ポケモン
-    drawBinaryString(tft, poke_information_type, 182, 78, 2, 1, romPath);
+}
+
+static void drawNumberRegion(void* ctx) {
+    const DexScreenView &v = *static_cast<const DexScreenView*>(ctx);
+    std::string str_dex_id = std::to_string(static_cast<unsigned int>(v.dex_id));
+    drawBinaryString(*v.tft, convertStringToCodes(str_dex_id, string2Byte), numberText, *v.rom);
+}
+
+static void drawNameRegion(void* ctx) {
+    const DexScreenView &v = *static_cast<const DexScreenView*>(ctx);
+    drawBinaryString(*v.tft, v.data->name, v.data->nameLength, nameText, *v.rom);
+}
+
+static void drawSpriteRegion(void* ctx) {
+    const DexScreenData &data = *static_cast<const DexScreenView*>(ctx)->data;
+    if (data.spriteSize > 0) {
+        draw2bpp_color(data.sprite, data.spriteWidth, data.spriteHeight, SPRITE_SCALE, data.palette, SPRITE_X, SPRITE_Y);
+    }
+}
+
+//ポケモンの種族名　〇〇ポケモン
+static void drawTypeRegion(void* ctx) {
+    const DexScreenView &v = *static_cast<const DexScreenView*>(ctx);
+    int typeEnd = drawBinaryString(*v.tft, v.data->type, v.data->typeLength, typeText, *v.rom);
     //文字列からバイト配列に変換し、表示
     std::vector<uint8_t>pokemon_str= convertStringToCodes("ポケモン", string2Byte);
-    drawBinaryString(tft, pokemon_str, 218, 78, 2, 1, romPath);
+    drawBinaryString(*v.tft, pokemon_str, typeSuffixBox(typeEnd), *v.rom);
+}
 
-     //ポケモンの高さ
-    
-    float f = height_weight[0] * 0.1f; // 10で割って小数点1桁にする
+//ポケモンの高さ
+static void drawHeightRegion(void* ctx) {
+    const DexScreenView &v = *static_cast<const DexScreenView*>(ctx);
+    float f = v.data->heightWeight[0] * 0.1f; // 10で割って小数点1桁にする
     char m[8];
     snprintf(m, sizeof(m), "%.1f", f);
+    int end = drawBinaryString(*v.tft, convertStringToCodes(m, string2Byte), heightText, *v.rom);
+    // "m"（ベース文字の段）
+    drawTileAt(unitX(heightText, end), heightText.y + 8 * heightText.scale, 0);
+}
 
-    drawBinaryString(tft, convertStringToCodes(m, string2Byte), 182, 96, 2, 1, romPath);
-    // "m"
-    drawTileAt(220, 104, 0);
-
-
-    //ポケモンの重さ
+//ポケモンの重さ
+static void drawWeightRegion(void* ctx) {
+    const DexScreenView &v = *static_cast<const DexScreenView*>(ctx);
+    const uint8_t* height_weight = v.data->heightWeight;
     char kg[8];
-      // 2バイトを結合（上位バイト << 8 | 下位バイト）
+    // 2バイトを結合（上位バイト << 8 | 下位バイト）
     uint16_t value = (height_weight[2] << 8) | height_weight[1];
     // 小数点1位までの値に変換（例：0.1単位にスケーリング）
     float fvalue = value * 0.1f;
     snprintf(kg, sizeof(kg), "%.1f", fvalue);
+    int end = drawBinaryString(*v.tft, convertStringToCodes(kg, string2Byte), weightText, *v.rom);
+    // 描画"kg"（ベース文字の段）
+    const int x = unitX(weightText, end);
+    const int y = weightText.y + 8 * weightText.scale;
+    drawTileAt(x, y, 1);
+    drawTileAt(x + 8, y, 2);
+}
+
+//ポケモンの図鑑説明
+static void drawTextRegion(void* ctx) {
+    const DexScreenView &v = *static_cast<const DexScreenView*>(ctx);
+    drawBinaryString(*v.tft, v.data->text, v.data->textLength, dexText, *v.rom);
+}
 
-    drawBinaryString(tft, convertStringToCodes(kg, string2Byte), 182, 112, 2, 1, romPath);
-    // 描画"kg"
-    drawTileAt(220, 120, 1);
-    drawTileAt(228, 120, 2);
-   
-    //ポケモンの図鑑説明
-    drawBinaryString(tft, dex_detail, 20, 156, 2, 1, romPath);
+// 図鑑画面の領域を登録する。マップの枠を下の層に置き、文字とスプライトは
+// 枠の内側の空白に重ねる（矩形は dex_layout.h の配置から決める）
+static int addDexRegion(const char* name, const DexRect &r, RenderEngine::DrawFn draw) {
+    return renderEngine.addRegion(name, r.x, r.y, r.w, r.h, 1, draw, &dexView);
+}
+
+static void setupDexScreenRegions() {
+    regionFrame  = renderEngine.addRegion("frame", 0, 0, MAP_W * 8, MAP_H * 8, 0, drawFrameRegion, &dexView);
+    regionNumber = addDexRegion("number", numberRect(), drawNumberRegion);
+    regionName   = addDexRegion("name", nameRect(), drawNameRegion);
+    regionSprite = addDexRegion("sprite", spriteRect(), drawSpriteRegion);
+    regionType   = addDexRegion("type", typeRect(), drawTypeRegion);
+    regionHeight = addDexRegion("height", heightRect(), drawHeightRegion);
+    regionWeight = addDexRegion("weight", weightRect(), drawWeightRegion);
+    regionText   = addDexRegion("text", dexTextRect(), drawTextRegion);
+}
 
+// 表示する内容のハッシュを各領域に渡す（変わった領域だけが次の render() で描き直される）
+static void setDexScreenContent(const DexScreenData &data, uint8_t dex_id) {
+    renderEngine.setContent(regionFrame, RenderEngine::hash(mapData, sizeof(mapData)));
+    renderEngine.setContent(regionNumber, RenderEngine::hash(&dex_id, 1));
+    renderEngine.setContent(regionName, RenderEngine::hash(data.name, data.nameLength));
+    uint32_t sprite = RenderEngine::hash(data.palette, sizeof(data.palette));
+    sprite = RenderEngine::hash(&data.spriteWidth, sizeof(data.spriteWidth), sprite);
+    renderEngine.setContent(regionSprite, RenderEngine::hash(data.sprite, data.spriteSize, sprite));
+    renderEngine.setContent(regionType, RenderEngine::hash(data.type, data.typeLength));
+    renderEngine.setContent(regionHeight, RenderEngine::hash(data.heightWeight, 1));
+    renderEngine.setContent(regionWeight, RenderEngine::hash(data.heightWeight + 1, 2));
+    renderEngine.setContent(regionText, RenderEngine::hash(data.text, data.textLength));
 }
 
+/**
+ * @brief Dex番号を指定してポケモンの名前・図鑑情報・圧縮スプライトを取得して描画する
+ * 
+ * @param rom 開いているROMイメージ
+ * @param tft TFTディスプレイオブジェクト
+ * @param dex_id Dex番号（1～151）
+ * @param index ROM索引
+ */
+
+void displayPokemonInfo(RomImage &rom, TFT_eSPI &tft, uint8_t dex_id,
+                        const RomIndex &index) {
+    uint32_t startTime = micros();
+    lcdDma.beginFrame();
+    const PokemonLocation* loc = index.find(dex_id);
+    if (!loc) {
+        Serial.printf("索引に Dex %d がありません\n", dex_id);
+        return;
+    }
 
+    // 先読み済みならそれを使い、無ければここで読み込む
+    static DexScreenData data;  // 約1.2KB、スタックに置かない
+    if (!dexPrefetcher.take(dex_id, data)) {
+        loadDexScreenData(rom, *loc, dex_id, data, &spriteAtlas);
+    }
+    Serial.printf("prefetch hit=%u miss=%u\n", dexPrefetcher.hits(), dexPrefetcher.misses());
+    // 描画中に次に押されそうなエントリを別コアで先読み
+    dexPrefetcher.request(dex_id);
+
+    // 各領域に今回の内容を渡し、変わった領域だけを描き直す
+    // （合成が有効ならオフスクリーン面に描き、最後に変わったブロックだけ送る）
+    bgColor = tft.color565(248, 232, 248); // fontの背景色をポケモンの色パレットに合わせる。
+    renderEngine.setBackground(bgColor);
+    dexView = { &rom, &tft, &data, dex_id };
+    setDexScreenContent(data, dex_id);
+
+    frameComposer.beginFrame();
+    const RenderEngine::Stats &rendered = renderEngine.render();
+    const FrameComposer::FrameStats &composed = frameComposer.endFrame();
+
+    Serial.printf("displayPokemonInfo: %lu us\n", (unsigned long)(micros() - startTime));
+    const LcdDma::FrameStats &frame = lcdDma.endFrame();
+    Serial.printf("  lcd: total=%u us cpu=%u us spi wait=%u us spi busy~%u us (%u pushes, %u bytes, %s)\n",
+                  frame.totalMicros, frame.cpuMicros(), frame.waitMicros, frame.spiMicros,
+                  frame.pushes, frame.bytes, lcdDma.dmaEnabled() ? "DMA" : "sync");
+    Serial.printf("  render: repainted=%u/%u regions %u px (%u us):", rendered.repainted,
+                  rendered.regions, rendered.pixels, rendered.micros);
+    for (int i = 0; i < RenderEngine::MAX_REGIONS; i++) {
+        if (rendered.changedMask & (1u << i)) Serial.printf(" %s", renderEngine.regionName(i));
+    }
+    Serial.println();
+    if (frameComposer.enabled()) {
+        Serial.printf("  compose: changed=%u/%u blocks rects=%u sent=%u bytes (%u us)\n",
+                      composed.changedBlocks, composed.blocks, composed.rects,
+                      composed.bytesSent, composed.composeMicros);
+    }
+
+}
+
+
+
+// ROM キャッシュ統計をシリアルに出力
+void printRomCacheStats() {
+    const RomPageCache::Stats &st = romImage.cacheStats();
+    uint32_t total = st.hits + st.misses;
+    Serial.printf("ROM cache: %u x %u bytes\n",
+                  (unsigned)romImage.cache().pageCount(), (unsigned)romImage.cache().pageSize());
+    Serial.printf("  hits=%u misses=%u hit率=%.1f%%\n",
+                  st.hits, st.misses, total ? 100.0f * st.hits / total : 0.0f);
+    Serial.printf("  fetched=%u bytes served=%u bytes\n", st.bytesFetched, st.bytesServed);
+    Serial.printf("prefetch: hits=%u misses=%u\n", dexPrefetcher.hits(), dexPrefetcher.misses());
+    if (romImage.source() == &packedRom) {
+        const PackedRomReader::Stats &pk = packedRom.stats();
+        Serial.printf("packed: %u -> %u bytes, block hits=%u misses=%u read=%u bytes decompress=%u us\n",
+                      (unsigned)packedRom.size(), (unsigned)packedRom.packedSize(),
+                      pk.blockHits, pk.blockMisses, pk.bytesRead, pk.decompressMicros);
+    }
+    if (romImage.source() == &sdRom) {
+        const SdRomReader::Stats &sd = sdRom.stats();
+        Serial.printf("SD: buffer hits=%u sync loads=%u prefetched=%u\n",
+                      sd.bufferHits, sd.syncLoads, sd.prefetches);
+    }
+    if (frameComposer.enabled()) {
+        const FrameComposer::Totals &ct = frameComposer.totals();
+        Serial.printf("compose: frames=%u sent=%u bytes (full redraw %u bytes)\n",
+                      ct.frames, ct.bytesSent, ct.bytesFull);
+    }
+}
+
+// 図鑑 151 件分の読み込み・展開時間を測る（ROM の読み出し元ごとの比較用）
+void benchmarkDexScreens() {
+    static DexScreenData data;
+    uint32_t total = 0;
+    uint32_t worst = 0;
+    for (uint8_t dex = 1; dex <= RomIndex::MAX_DEX; dex++) {
+        const PokemonLocation* loc = romIndex.find(dex);
+        if (!loc) continue;
+        uint32_t start = micros();
+        loadDexScreenData(romImage, *loc, dex, data, &spriteAtlas);
+        uint32_t elapsed = micros() - start;
+        total += elapsed;
+        if (elapsed > worst) worst = elapsed;
+    }
+    Serial.printf("dex screens: total=%u us avg=%u us max=%u us\n",
+                  total, total / RomIndex::MAX_DEX, worst);
+    printRomCacheStats();
+}
+
+// 151 匹分のスプライト展開だけを繰り返して測る（ROM 読み出しは計測に含めない）
+void benchmarkSpriteDecode(int rounds = 10) {
+    static uint8_t compressed[DexScreenData::COMPRESSED_MAX];
+    static PicDecoder::Scratch scratch;
+    static uint8_t out[PicDecoder::OUTPUT_MAX];
+    PicDecoder decoder(scratch);
+    uint32_t elapsed = 0;
+    uint32_t outBytes = 0;
+    int failures = 0;
+    for (uint8_t dex = 1; dex <= RomIndex::MAX_DEX; dex++) {
+        const PokemonLocation* loc = romIndex.find(dex);
+        if (!loc || loc->spriteLength > sizeof(compressed)) continue;
+        RomSpan src = viewCompressedPokemonSprite(romImage, *loc, compressed);
+        uint32_t start = micros();
+        int n = 0;
+        for (int i = 0; i < rounds; i++) n = decoder.decode(src.data, src.size, out, sizeof(out));
+        elapsed += micros() - start;
+        if (n < 0) {
+            failures++;
+            continue;
+        }
+        outBytes += n * rounds;
+    }
+    uint32_t decodes = RomIndex::MAX_DEX * rounds;
+    Serial.printf("sprite decode: %u decodes %u us (%.1f us/sprite, %.1f KB/s out) failures=%d\n",
+                  decodes, elapsed, (float)elapsed / decodes,
+                  elapsed ? outBytes * 1000.0f / 1024.0f / elapsed * 1000.0f : 0.0f, failures);
+    Serial.printf("  decoder scratch=%u bytes output=%u bytes\n",
+                  (unsigned)sizeof(PicDecoder::Scratch), (unsigned)PicDecoder::OUTPUT_MAX);
+}
+
+// 列ごとの描画コールバック（最初の列を描き終えた時刻を記録する）
+struct StreamDrawContext {
+    const uint16_t* palette;
+    uint32_t start;
+    uint32_t firstPixel;
+};
+
+static void drawSpriteColumn(int tileColumn, int width, const uint8_t* out, void* ctx) {
+    StreamDrawContext* c = static_cast<StreamDrawContext*>(ctx);
+    draw2bpp_column(out, width * 8, width * 8, tileColumn, SPRITE_SCALE, c->palette, SPRITE_X, SPRITE_Y);
+    if (tileColumn == 0) c->firstPixel = micros() - c->start;
+}
+
+// 現在の Dex のスプライトを「全部展開してから描画」と「列ごとに展開しながら描画」で比べる
+void benchmarkSpriteStreaming() {
+    static uint8_t compressed[DexScreenData::COMPRESSED_MAX];
+    static PicDecoder::Scratch scratch;
+    static uint8_t out[PicDecoder::OUTPUT_MAX];
+    const PokemonLocation* loc = romIndex.find(dex_id);
+    if (!loc || loc->spriteLength > sizeof(compressed)) return;
+    RomSpan src = viewCompressedPokemonSprite(romImage, *loc, compressed);
+    uint16_t palette[4];
+    getPokemonColorPalette(romImage, *loc, palette);
+    PicDecoder decoder(scratch);
+
+    // 全部展開してから描画
+    uint32_t start = micros();
+    int n = decoder.decode(src.data, src.size, out, sizeof(out));
+    if (n < 0) {
+        Serial.println("sprite stream: 展開失敗");
+        return;
+    }
+    int width = decoder.width();
+    uint32_t decoded = micros() - start;
+    uint32_t firstPixel = 0;
+    for (int tc = 0; tc < width; tc++) {
+        draw2bpp_column(out, width * 8, width * 8, tc, SPRITE_SCALE, palette, SPRITE_X, SPRITE_Y);
+        if (tc == 0) firstPixel = micros() - start;
+    }
+    uint32_t total = micros() - start;
+    Serial.printf("sprite sequential: decode=%u us first pixel=%u us total=%u us\n", decoded, firstPixel, total);
+
+    // 列ごとに展開しながら描画
+    StreamDrawContext ctx = { palette, static_cast<uint32_t>(micros()), 0 };
+    decoder.decode(src.data, src.size, out, sizeof(out), drawSpriteColumn, &ctx);
+    Serial.printf("sprite streaming:  first pixel=%u us total=%u us\n", ctx.firstPixel, (unsigned)(micros() - ctx.start));
+    // 合成を通さずにパネルへ描いたので、次の画面は全部描き直して送る
+    frameComposer.invalidate();
+    renderEngine.invalidate();
+}
+
+// 比較用: 以前の描画方法（1 画素ごとに fillRect）
+static void drawSpritePerPixel(const uint8_t* data, int width, int height, int scale,
+                               const uint16_t* palette, int x0, int y0) {
+    int tilesX = width / 8;
+    for (int row = 0; row < height; row++) {
+        const uint8_t* line = &data[row * tilesX * 2];
+        for (int tx = 0; tx < tilesX; tx++) {
+            uint8_t lo = line[tx * 2];
+            uint8_t hi = line[tx * 2 + 1];
+            for (int bit = 7; bit >= 0; bit--) {
+                uint16_t c = palette[((hi >> bit) & 1) << 1 | ((lo >> bit) & 1)];
+                tft.fillRect((x0 + tx * 8 + 7 - bit) * scale, (y0 + row) * scale, scale, scale, c);
+            }
+        }
+    }
+}
+
+// 40x40 / 48x48 / 56x56 のスプライトを 1 匹ずつ選び、画素ごとの fillRect と
+// ラインバッファ転送（draw2bpp_color）で描画時間を比べる。最後に現在の画面を描き直す
+void benchmarkSpriteBlit() {
+    static PicDecoder::Scratch scratch;
+    static uint8_t out[PicDecoder::OUTPUT_MAX];
+    PicDecoder decoder(scratch);
+    bool measured[3] = {};
+    for (uint8_t dex = 1; dex <= RomIndex::MAX_DEX; dex++) {
+        const PokemonLocation* loc = romIndex.find(dex);
+        if (!loc || decodePokemonSprite(romImage, *loc, decoder, out, sizeof(out)) < 0) continue;
+        int tiles = decoder.width();
+        if (tiles < 5 || measured[tiles - 5]) continue;
+        measured[tiles - 5] = true;
+        uint16_t palette[4];
+        getPokemonColorPalette(romImage, *loc, palette);
+        int size = tiles * 8;
+
+        uint32_t start = micros();
+        drawSpritePerPixel(out, size, size, SPRITE_SCALE, palette, SPRITE_X, SPRITE_Y);
+        uint32_t before = micros() - start;
+        start = micros();
+        draw2bpp_color(out, size, size, SPRITE_SCALE, palette, SPRITE_X, SPRITE_Y);
+        uint32_t after = micros() - start;
+        Serial.printf("sprite blit %dx%d (dex %d): fillRect=%u us line buffer=%u us\n",
+                      size, size, dex, before, after);
+    }
+    frameComposer.invalidate();
+    renderEngine.invalidate();
+    displayPokemonInfo(romImage, tft, dex_id, romIndex);
+}
+
+// マップの枠を、タイルごとの転送（以前の方法）とスパンごとの転送（drawMap）で描き、
+// SPI の転送回数・バイト数・時間を比べる。最後に現在の画面を描き直す
+void benchmarkMapDraw() {
+    lcdDma.beginFrame();
+    lcdDma.beginBatch();
+    for (int my = 0; my < MAP_H; my++) {
+        for (int mx = 0; mx < MAP_W; mx++) {
+            if (mapData[my][mx] != 0) drawTileAt(mx * 8, my * 8, mapData[my][mx]);
+        }
+    }
+    lcdDma.endBatch();
+    const LcdDma::FrameStats before = lcdDma.endFrame();
+
+    lcdDma.beginFrame();
+    drawMap();
+    const LcdDma::FrameStats after = lcdDma.endFrame();
+    Serial.printf("map draw: per tile=%u transfers %u bytes %u us, spans=%u transfers %u bytes %u us\n",
+                  before.pushes, before.bytes, before.totalMicros, after.pushes, after.bytes, after.totalMicros);
+
+    frameComposer.invalidate();
+    renderEngine.invalidate();
+    displayPokemonInfo(romImage, tft, dex_id, romIndex);
+}
+
+// --- シリアルコマンド ---
+// s: ROM キャッシュ統計を表示, r: 統計をリセット, b: 図鑑全件の読み込み時間を測る,
+// d: スプライト展開だけの速度を測る, t: スプライトの逐次展開・描画の最初の画素までの時間を測る,
+// p: スプライト描画（画素ごとの fillRect とラインバッファ転送）の時間を比べる,
+// m: マップ描画（タイルごとの転送とスパンごとの転送）の転送回数を比べる
+void handleSerialCommand() {
+    while (Serial.available()) {
+        switch (Serial.read()) {
+            case 's':
+                printRomCacheStats();
+                break;
+            case 'r':
+                romImage.resetCacheStats();
+                dexPrefetcher.resetStats();
+                sdRom.resetStats();
+                packedRom.resetStats();
+                frameComposer.resetTotals();
+                Serial.println("ROM cache 統計リセット");
+                break;
+            case 'b':
+                benchmarkDexScreens();
+                break;
+            case 'd':
+                benchmarkSpriteDecode();
+                break;
+            case 't':
+                benchmarkSpriteStreaming();
+                break;
+            case 'p':
+                benchmarkSpriteBlit();
+                break;
+            case 'm':
+                benchmarkMapDraw();
+                break;
+        }
+    }
+}
 
 // --- main ---
 void setup() {
@@ -268,10 +641,6 @@ void setup() {
     //mcp.pullUp(i, HIGH); // 内部プルアップ有効
   }
 
-  // 文字列をバイナリコードに変換して表示
-   //逆引きにより、文字列をバイト配列に変換
-    string2Byte= BuildChar2ByteTable();
-
 
     if (!LittleFS.begin(true)) {
         Serial.println("LittleFS 初期化失敗");
@@ -280,6 +649,15 @@ void setup() {
 
     tft.init();
     tft.setRotation(1);
+    if (!lcdDma.begin(tft)) {
+        Serial.println("LCD DMA 初期化失敗（同期転送で描画します）");
+    }
+    if (frameComposer.begin(tft)) {
+        Serial.println("画面合成: 有効（変わった 8x8 ブロックだけ送ります）");
+    } else {
+        Serial.println("画面合成: 無効（PSRAM なし、変わった領域を直接描きます）");
+    }
+    setupDexScreenRegions();
     uint16_t myColor = tft.color565(248, 232, 248); // 白紫系
     tft.fillScreen(myColor);
 
@@ -287,64 +665,130 @@ void setup() {
     //tft.fillScreen(TFT_WHITE);
 
     //const std::string romPath = "/pokemon_blue.gb";
-    const std::string romPath = "/pokemon_blue.gb";
-    // 1度だけ読み込む
-    std::vector<uint8_t> stopByte; // 今回は未使用(空)
-    // 0x42784 から 190 バイト読み込み ポケモンのロムインデックスに対応した図鑑番号を取得
-    index_to_dex = readROMData(romPath, 0x42784, 190, stopByte);
-    // 逆引きテーブル作成
-    dex_to_index = buildDexToIndex(index_to_dex);
+    // ROM パーティションがあればマップして使い、無ければ SD カード、
+    // LittleFS の圧縮 ROM、LittleFS の ROM の順に探す
+    if (romImage.openMapped(romPartition)) {
+        Serial.println("ROM パーティションをマップしました");
+    } else {
+        if (!romImage.enableCache(romCachePageSize, romCachePageCount, romCacheUsePsram)) {
+            Serial.println("ROM キャッシュ確保失敗（キャッシュなしで続行）");
+        }
+        spiSD.begin(12, 14, 27, sdCsPin);  // SCK, MISO, MOSI, CS
+        if (sdRom.begin(spiSD, sdCsPin) && romImage.openSource(sdRom, romSdPath)) {
+            Serial.printf("SD カードの ROM を開きました: %s\n", romSdPath.c_str());
+        } else if (romImage.openSource(packedRom, romPackPath)) {
+            Serial.printf("圧縮 ROM を開きました: %u -> %u bytes\n",
+                          (unsigned)packedRom.size(), (unsigned)packedRom.packedSize());
+        } else if (romImage.open(romPath)) {
+            Serial.println("LittleFS の ROM を開きました");
+        } else {
+            Serial.println("ROM ファイル開けません");
+            for (const std::string &name : sdRom.listRoms("/roms")) {
+                Serial.printf("  SD: %s\n", name.c_str());
+            }
+            return;
+        }
+    }
+    // ヘッダ（と CRC32 キャッシュ）から ROM バリアントを判定
+    RomIdentity romId;
+    if (!identifyRom(romImage, romIdPath, romId)) {
+        Serial.println("ROM ヘッダ読み込み失敗");
+        return;
+    }
+    Serial.printf("ROM: %s dest=%d ver=%d CRC32=%08X checksum=%s\n",
+                  romId.header.title, romId.header.destination, romId.header.version,
+                  romId.crc32, romId.globalChecksumOk ? "OK" : "NG");
+    romProfile = findRomProfile(romId);
+    if (!romProfile) {
+        Serial.println("未対応の ROM です");
+        return;
+    }
+    Serial.printf("プロファイル: %s\n", romProfile->name);
+
+  // 文字列をバイナリコードに変換して表示
+   //逆引きにより、文字列をバイト配列に変換
+    string2Byte= BuildChar2ByteTable(*romProfile->charset);
+
+    // 索引ファイルがあり ROM ヘッダのチェックサムが一致すればそれを使う
+    RomIndexKey romKey;
+    RomIndexKey::fromRom(romImage, romKey);
+    if (romIndex.load(indexPath, romKey)) {
+        Serial.println("索引ファイル読み込み完了");
+    } else {
+        Serial.println("索引ファイル作成中...");
+        std::vector<uint8_t> stopByte; // 今回は未使用(空)
+        // ポケモンのロムインデックスに対応した図鑑番号を取得
+        index_to_dex = readROMData(romImage, romProfile->indexToDex, romProfile->indexToDexLength, stopByte);
+        // 逆引きテーブル作成
+        dex_to_index = buildDexToIndex(index_to_dex);
+        if (buildRomIndex(romImage, *romProfile, dex_to_index, romIndex) && romIndex.save(indexPath)) {
+            Serial.println("索引ファイル保存完了");
+        } else {
+            Serial.println("索引ファイル保存失敗");
+        }
+    }
+
+    // スプライトアトラス（無ければ全スプライトを展開して作る）
+    if (!spriteAtlas.open(atlasPath, romKey)) {
+        Serial.println("スプライトアトラス作成中...");
+        uint32_t start = millis();
+        if (SpriteAtlas::build(romImage, romIndex, atlasPath) && spriteAtlas.open(atlasPath, romKey)) {
+            Serial.printf("スプライトアトラス作成完了 (%lu ms)\n", (unsigned long)(millis() - start));
+        } else {
+            Serial.println("スプライトアトラス作成失敗（毎回展開します）");
+        }
+    }
 
     // タイルセット構築
     buildTileSet();
 
+    // 先読みタスク開始（loop() は core 1 で動くので core 0 に置く）
+    dexPrefetcher.setAtlas(&spriteAtlas);
+    if (!dexPrefetcher.begin(romImage, romIndex, 0)) {
+        Serial.println("先読みタスク開始失敗");
+    }
+
     //ポケモン図鑑の初期表示
-    displayPokemonInfo(romPath,tft,dex_id, dex_to_index);
+    displayPokemonInfo(romImage,tft,dex_id, romIndex);
 
 
 
 }
 
 void loop() {
-    static uint8_t dex_id = 1;                   // Dex番号: 1～151
     static bool lastPressed[4] = {false,false,false,false};
 
+    handleSerialCommand();
+
     for (uint8_t i = 0; i < 4; i++) {
         bool currentlyPressed = (mcp.digitalRead(i) == LOW); // LOWが押下
 
         // 押した瞬間だけ反応（エッジ検出）
         if (currentlyPressed && !lastPressed[i]) {
 
-            // 画面全体を白でクリア
-            uint16_t myColor = tft.color565(248, 232, 248); // 白紫系
-            tft.fillScreen(myColor);
-            //tft.fillScreen(TFT_WHITE);
+            // 画面は displayPokemonInfo（RenderEngine）で変わった領域だけ描き直す
 
             // ボタンごとの処理
             switch(i) {
                 case 0: // ボタン1: 1単位でインクリメント
-                    dex_id++;
-                    if (dex_id > 151) dex_id = 1;
+                    dex_id = stepDex(dex_id, +1);
                     break;
 
                 case 1: // ボタン2: 1単位でデクリメント
-                    if (dex_id == 1) dex_id = 151;
-                    else dex_id--;
+                    dex_id = stepDex(dex_id, -1);
                     break;
 
                 case 2: // ボタン3: 10単位でインクリメント
-                    dex_id += 10;
-                    if (dex_id > 151) dex_id -= 151;
+                    dex_id = stepDex(dex_id, +10);
                     break;
 
                 case 3: // ボタン4: 10単位でデクリメント
-                    if (dex_id <= 10) dex_id = 151 - (10 - dex_id);
-                    else dex_id -= 10;
+                    dex_id = stepDex(dex_id, -10);
                     break;
             }
 
             // 選択したDex番号のポケモン情報を表示
-            displayPokemonInfo(romPath, tft, dex_id, dex_to_index);
+            displayPokemonInfo(romImage, tft, dex_id, romIndex);
         }
 
         // 現在の押下状態を保存
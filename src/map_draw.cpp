@@ -1,4 +1,7 @@
 #include "map_draw.h"
+#include "render/lcd_dma.h"
+#include <esp_heap_caps.h>
+#include <cstring>
 
 std::vector<const uint8_t*> tileset;
 uint16_t gb_palette[4] = {
@@ -57,37 +60,139 @@ void decodeTile2bpp(const uint8_t* tileData, uint16_t* outBuf) {
     }
   }
 }
+// ----------------------------
+// 展開済みタイルのキャッシュ
+// tileset の各タイルを gb_palette で RGB565 にし、パネルに送る順にバイトスワップして持つ。
+// DMA で読めるメモリに置けたときは LcdDma からコピーせずにそのまま送る。置けずに普通の
+// メモリ（PSRAM のこともある）に置いたときは、LcdDma のバッファにコピーしてから送る。
+// 展開したときのパレットを覚えておき、gb_palette が変わったら全部展開し直す。
+// ----------------------------
+static constexpr int TILE_PIXELS = 8 * 8;
+static uint16_t* tileCache = nullptr;      // tileCacheCount x 64 画素
+static bool tileCacheDma = false;          // tileCache を DMA で直接読めるか
+static size_t tileCacheCount = 0;
+static std::vector<bool> tileCached;
+static std::vector<bool> tileSolid;        // 64 画素すべて同じ色
+static uint16_t tileCachePalette[4];
+
+void invalidateTileCache() {
+    tileCached.assign(tileCached.size(), false);
+}
+
+// 描画を始める前に、タイル数とパレットがキャッシュと合っているか確かめる
+static bool syncTileCache() {
+    if (tileCacheCount != tileset.size()) {
+        heap_caps_free(tileCache);
+        tileCacheCount = tileset.size();
+        size_t bytes = tileCacheCount * TILE_PIXELS * sizeof(uint16_t);
+        tileCache = static_cast<uint16_t*>(heap_caps_malloc(bytes, MALLOC_CAP_DMA | MALLOC_CAP_8BIT));
+        tileCacheDma = tileCache != nullptr;
+        if (!tileCache) tileCache = static_cast<uint16_t*>(heap_caps_malloc(bytes, MALLOC_CAP_8BIT));
+        if (!tileCache) tileCacheCount = 0;
+        tileCached.assign(tileCacheCount, false);
+        tileSolid.assign(tileCacheCount, false);
+    }
+    if (memcmp(tileCachePalette, gb_palette, sizeof(tileCachePalette)) != 0) {
+        memcpy(tileCachePalette, gb_palette, sizeof(tileCachePalette));
+        invalidateTileCache();
+    }
+    return tileCache != nullptr;
+}
+
+static const uint16_t* cachedTile(uint8_t tileNum) {
+    uint16_t* tile = tileCache + tileNum * TILE_PIXELS;
+    if (!tileCached[tileNum]) {
+        decodeTile2bpp(tileset[tileNum], tile);
+        bool solid = true;
+        for (int i = 0; i < TILE_PIXELS; i++) {
+            solid = solid && tile[i] == tile[0];
+            tile[i] = LcdDma::swap(tile[i]);
+        }
+        tileSolid[tileNum] = solid;
+        tileCached[tileNum] = true;
+    }
+    return tile;
+}
+
+static void pushTile(int x, int y, uint8_t tileNum) {
+    if (tileNum >= tileCacheCount) return;
+    if (tileCacheDma) {
+        lcdDma.pushPixels(x, y, 8, 8, cachedTile(tileNum));
+        return;
+    }
+    memcpy(lcdDma.buffer(), cachedTile(tileNum), TILE_PIXELS * sizeof(uint16_t));
+    lcdDma.push(x, y, 8, 8);
+}
+
+// マップの my 行目のタイル [mx0, mx1)（空白なし）を 1 回の転送で送る
+static void pushSpan(int my, int mx0, int mx1) {
+    const int TILE = 8;
+    const int x = mx0 * TILE;
+    const int y = my * TILE;
+    const int w = (mx1 - mx0) * TILE;
+
+    // 同じ色の無地タイルだけなら塗りつぶしで送る
+    const uint16_t* first = cachedTile(mapData[my][mx0]);
+    bool solid = true;
+    for (int mx = mx0; mx < mx1 && solid; mx++) {
+        uint8_t tileNum = mapData[my][mx];
+        solid = tileSolid[tileNum] && cachedTile(tileNum)[0] == first[0];
+    }
+    if (solid) {
+        lcdDma.fill(x, y, w, TILE, LcdDma::swap(first[0]));
+        return;
+    }
+    // 1 タイルならキャッシュから送る
+    if (mx1 - mx0 == 1) {
+        pushTile(x, y, mapData[my][mx0]);
+        return;
+    }
+    // 8 行分のラインバッファにタイルを横に並べる
+    uint16_t* buf = lcdDma.buffer();
+    for (int mx = mx0; mx < mx1; mx++) {
+        const uint16_t* tile = cachedTile(mapData[my][mx]);
+        uint16_t* dst = buf + (mx - mx0) * TILE;
+        for (int row = 0; row < TILE; row++) {
+            memcpy(dst + row * w, tile + row * TILE, TILE * sizeof(uint16_t));
+        }
+    }
+    lcdDma.push(x, y, w, TILE);
+}
+
 // ----------------------------
 // マップを一気に描画
+// 各行を空白タイルで区切ったスパンごとに 1 回の転送で送る
 // ----------------------------
 void drawMap() {
-    const int TILE = 8;
-    uint16_t tileBuf[TILE * TILE];
+    const int MAX_SPAN = LcdDma::BUFFER_PIXELS / TILE_PIXELS;  // 1 回で送れるタイル数
+    if (!lcdDma.ready() || !syncTileCache()) return;
 
+    lcdDma.beginBatch();
     for (int my = 0; my < MAP_H; my++) {
-        for (int mx = 0; mx < MAP_W; mx++) {
-            uint8_t tileNum = mapData[my][mx];
-
+        int mx = 0;
+        while (mx < MAP_W) {
             // 空白タイルなら描画せずスキップ
-            if (tileNum == 0) continue;
-
-            // タイルをデコードしてバッファに展開
-            decodeTile2bpp(tileset[tileNum], tileBuf);
-
-            // 一気に描画
-            tft.pushImage(mx * TILE, my * TILE, TILE, TILE, tileBuf);
+            if (mapData[my][mx] == 0 || mapData[my][mx] >= tileCacheCount) {
+                mx++;
+                continue;
+            }
+            int end = mx + 1;
+            while (end < MAP_W && end - mx < MAX_SPAN && mapData[my][end] != 0 &&
+                   mapData[my][end] < tileCacheCount) {
+                end++;
+            }
+            pushSpan(my, mx, end);
+            mx = end;
         }
     }
+    lcdDma.endBatch();
 }
 
 void drawTileAt(int x, int y, uint8_t tileNum) {
-    const int TILE = 8;
-    uint16_t tileBuf[TILE * TILE];
-
-    // タイルデコード
-    decodeTile2bpp(tileset[tileNum], tileBuf);
+    if (!lcdDma.ready() || !syncTileCache()) return;
 
     // ILI9341 に描画
-    tft.pushImage(x, y, TILE, TILE, tileBuf);
+    lcdDma.beginBatch();
+    pushTile(x, y, tileNum);
+    lcdDma.endBatch();
 }
-
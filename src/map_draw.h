@@ -17,6 +17,8 @@ extern uint8_t mapData[MAP_H][MAP_W];
 void decodeTile2bpp(const uint8_t* tileData, uint16_t* outBuf);
 void drawMap();
 void drawTileAt(int x, int y, uint8_t tileNum);
+// 展開済みタイルを捨てる（tileset の中身を差し替えたとき。gb_palette の変更は自動で反映される）
+void invalidateTileCache();
 
 
 
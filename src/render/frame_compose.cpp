@@ -0,0 +1,116 @@
+#include "render/frame_compose.h"
+#include "render/lcd_dma.h"
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <cstring>
+
+FrameComposer::~FrameComposer() {
+    heap_caps_free(frame_);
+    heap_caps_free(hashes_);
+}
+
+bool FrameComposer::begin(TFT_eSPI &tft) {
+    width_ = tft.width();
+    height_ = tft.height();
+    blocksX_ = (width_ + BLOCK - 1) / BLOCK;
+    blocksY_ = (height_ + BLOCK - 1) / BLOCK;
+    if (!frame_) {
+        frame_ = static_cast<uint16_t*>(heap_caps_malloc(width_ * height_ * sizeof(uint16_t), MALLOC_CAP_SPIRAM));
+    }
+    if (!hashes_) {
+        hashes_ = static_cast<uint32_t*>(heap_caps_malloc(blocksX_ * blocksY_ * sizeof(uint32_t), MALLOC_CAP_8BIT));
+    }
+    if (!frame_ || !hashes_ || !lcdDma.ready()) {
+        heap_caps_free(frame_);
+        frame_ = nullptr;
+        return false;
+    }
+    memset(frame_, 0, width_ * height_ * sizeof(uint16_t));
+    hashesValid_ = false;
+    return true;
+}
+
+void FrameComposer::invalidate() {
+    hashesValid_ = false;
+}
+
+void FrameComposer::beginFrame() {
+    if (!enabled()) return;
+    lcdDma.beginCapture(frame_, width_, height_);
+    inFrame_ = true;
+}
+
+// 8x8 ブロックの画素を 32bit ずつ混ぜる（画面端のブロックは画面内の分だけ）
+uint32_t FrameComposer::hashBlock(int bx, int by) const {
+    const int x0 = bx * BLOCK;
+    const int y0 = by * BLOCK;
+    const int w = x0 + BLOCK > width_ ? width_ - x0 : BLOCK;
+    const int h = y0 + BLOCK > height_ ? height_ - y0 : BLOCK;
+    uint32_t hash = 2166136261u;
+    for (int y = 0; y < h; y++) {
+        const uint16_t* row = frame_ + (y0 + y) * width_ + x0;
+        for (int x = 0; x < w; x += 2) {
+            uint32_t v = row[x] | (x + 1 < w ? uint32_t(row[x + 1]) << 16 : 0);
+            hash = (hash ^ v) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+// ブロック行 by のブロック [bx0, bx1) を 1 矩形で送る（LcdDma のバッファに入る幅ずつ）
+void FrameComposer::flushRun(int by, int bx0, int bx1) {
+    const int y0 = by * BLOCK;
+    const int h = y0 + BLOCK > height_ ? height_ - y0 : BLOCK;
+    const int maxBlocks = LcdDma::BUFFER_PIXELS / (BLOCK * BLOCK);
+    while (bx0 < bx1) {
+        int end = bx1 - bx0 > maxBlocks ? bx0 + maxBlocks : bx1;
+        const int x0 = bx0 * BLOCK;
+        const int w = (end * BLOCK > width_ ? width_ : end * BLOCK) - x0;
+        uint16_t* buf = lcdDma.buffer();
+        for (int y = 0; y < h; y++) {
+            memcpy(buf + y * w, frame_ + (y0 + y) * width_ + x0, w * sizeof(uint16_t));
+        }
+        lcdDma.push(x0, y0, w, h);
+        last_.rects++;
+        last_.bytesSent += w * h * 2;
+        bx0 = end;
+    }
+}
+
+const FrameComposer::FrameStats& FrameComposer::endFrame() {
+    last_ = FrameStats();
+    if (!enabled() || !inFrame_) return last_;
+    inFrame_ = false;
+    lcdDma.endCapture();
+
+    uint32_t start = micros();
+    last_.blocks = blocksX_ * blocksY_;
+    lcdDma.beginBatch();
+    for (int by = 0; by < blocksY_; by++) {
+        int runStart = -1;
+        for (int bx = 0; bx <= blocksX_; bx++) {
+            bool changed = false;
+            if (bx < blocksX_) {
+                uint32_t hash = hashBlock(bx, by);
+                uint32_t &old = hashes_[by * blocksX_ + bx];
+                changed = !hashesValid_ || hash != old;
+                old = hash;
+                if (changed) last_.changedBlocks++;
+            }
+            // 変わったブロックが続く間は 1 つの矩形にまとめる
+            if (changed && runStart < 0) runStart = bx;
+            if (!changed && runStart >= 0) {
+                flushRun(by, runStart, bx);
+                runStart = -1;
+            }
+        }
+    }
+    lcdDma.endBatch();
+    hashesValid_ = true;
+    last_.composeMicros = micros() - start;
+
+    totals_.frames++;
+    totals_.bytesSent += last_.bytesSent;
+    totals_.bytesFull += width_ * height_ * 2;
+    return last_;
+}
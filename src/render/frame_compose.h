@@ -0,0 +1,72 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <TFT_eSPI.h>
+
+/**
+ * @brief 画面をオフスクリーン面に描いてから、前の画面と違う 8x8 ブロックだけを送る合成レイヤ
+ *
+ * beginFrame() から endFrame() の間、LcdDma に push() された描画はすべて
+ * PSRAM 上の画面 1 枚分の面（スワップ済み RGB565）に書かれる。endFrame() で
+ * 面を 8x8 ブロックごとにハッシュし、前のフレームを送ったときのハッシュと違う
+ * ブロックを行ごとに横へつなげた矩形として LcdDma でパネルに送る。
+ * 前の画面そのものは持たず、ブロックごとのハッシュ（40x30 x 4 バイト）だけを覚える。
+ *
+ * 面はフレームをまたいで残るので、描き直すのは変わった部分（RenderEngine の領域）だけでよい。
+ *
+ * 面を確保できない（PSRAM が無い）場合は無効になり、描画はそのままパネルに送られる。
+ * 合成を通さずにパネルへ描いたときは invalidate() で次のフレームを全部送らせる。
+ */
+class FrameComposer {
+public:
+    static constexpr int BLOCK = 8;
+
+    struct FrameStats {
+        uint32_t blocks = 0;          // 画面のブロック数
+        uint32_t changedBlocks = 0;   // 送ったブロック数
+        uint32_t rects = 0;           // 送った矩形の数
+        uint32_t bytesSent = 0;       // 送ったバイト数
+        uint32_t composeMicros = 0;   // ハッシュ計算と差分の送信にかかった時間
+    };
+    struct Totals {
+        uint32_t frames = 0;
+        uint32_t bytesSent = 0;
+        uint32_t bytesFull = 0;       // 毎回全画面を送った場合のバイト数
+    };
+
+    FrameComposer() = default;
+    ~FrameComposer();
+    FrameComposer(const FrameComposer&) = delete;
+    FrameComposer& operator=(const FrameComposer&) = delete;
+
+    // lcdDma.begin() の後に呼ぶ。true なら合成が有効
+    bool begin(TFT_eSPI &tft);
+    bool enabled() const { return frame_ != nullptr; }
+
+    // 前のフレームの面の上に描き始める
+    void beginFrame();
+    // 変わったブロックを送ってフレームを終える
+    const FrameStats& endFrame();
+    void invalidate();
+
+    const FrameStats& lastFrame() const { return last_; }
+    const Totals& totals() const { return totals_; }
+    void resetTotals() { totals_ = Totals(); }
+
+private:
+    uint32_t hashBlock(int bx, int by) const;
+    void flushRun(int by, int bx0, int bx1);
+
+    uint16_t* frame_ = nullptr;     // width_ x height_（スワップ済み RGB565）
+    uint32_t* hashes_ = nullptr;    // パネルに出ているブロックのハッシュ
+    bool hashesValid_ = false;      // false なら次のフレームは全ブロックを送る
+    int width_ = 0;
+    int height_ = 0;
+    int blocksX_ = 0;
+    int blocksY_ = 0;
+    bool inFrame_ = false;
+    FrameStats last_;
+    Totals totals_;
+};
+
+extern FrameComposer frameComposer;
@@ -0,0 +1,28 @@
+#include "render/glyph.h"
+#include "render/lcd_dma.h"
+#include <cstring>
+
+void drawFont8x8(TFT_eSPI &tft, int x, int y, const uint8_t buf[8], uint16_t color, uint16_t bg, uint8_t scale) {
+    const int side = 8 * scale;
+    if (!lcdDma.ready() || scale == 0) return;
+    const int bandRows = (int)LcdDma::BUFFER_PIXELS / (side * scale);  // 1 回で送る文字の行数
+    if (bandRows == 0) return;
+
+    const uint16_t fg = LcdDma::swap(color);
+    const uint16_t bgs = LcdDma::swap(bg);
+    lcdDma.beginBatch();
+    for (int row0 = 0; row0 < 8; row0 += bandRows) {
+        const int rows = bandRows < 8 - row0 ? bandRows : 8 - row0;
+        uint16_t* dst = lcdDma.buffer();
+        for (int r = 0; r < rows; r++) {
+            uint16_t* line = dst + r * scale * side;
+            for (int col = 0; col < 8; col++) {
+                uint16_t c = (buf[row0 + r] >> (7 - col)) & 1 ? fg : bgs;
+                for (int s = 0; s < scale; s++) line[col * scale + s] = c;
+            }
+            for (int s = 1; s < scale; s++) memcpy(line + s * side, line, side * sizeof(uint16_t));
+        }
+        lcdDma.push(x, y + row0 * scale, side, rows * scale);
+    }
+    lcdDma.endBatch();
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include <stdint.h>
+#include <TFT_eSPI.h>
+
+// --- 8x8 フォント描画 ---
+// 1 ビット 1 画素の 8x8 の文字（buf[row] の上位ビットが左）を scale 倍にして (x, y) に描く。
+// 拡大後の文字を LcdDma のバッファに展開して 1 矩形で送る。
+// 1 面に入らない大きさ（scale 6 以上）は文字の数行ずつに分けて送り、1 行も入らない倍率（17 以上）は描かない
+void drawFont8x8(TFT_eSPI &tft, int x, int y, const uint8_t buf[8], uint16_t color, uint16_t bg, uint8_t scale);
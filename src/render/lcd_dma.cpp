@@ -0,0 +1,136 @@
+#include "render/lcd_dma.h"
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <cstring>
+
+// SPI クロック（User_Setup の SPI_FREQUENCY）。転送時間の見積もりにだけ使う
+#ifdef SPI_FREQUENCY
+static constexpr uint32_t SPI_HZ = SPI_FREQUENCY;
+#else
+static constexpr uint32_t SPI_HZ = 40000000;
+#endif
+
+LcdDma::~LcdDma() {
+    for (uint16_t* &buf : bufs_) {
+        heap_caps_free(buf);
+        buf = nullptr;
+    }
+}
+
+bool LcdDma::begin(TFT_eSPI &tft) {
+    tft_ = &tft;
+    bool dmaCapable = true;
+    for (uint16_t* &buf : bufs_) {
+        if (!buf) buf = static_cast<uint16_t*>(heap_caps_malloc(BUFFER_PIXELS * 2, MALLOC_CAP_DMA | MALLOC_CAP_8BIT));
+        // DMA 用に確保できなければ同期転送用に普通のメモリで持つ
+        if (!buf) {
+            buf = static_cast<uint16_t*>(heap_caps_malloc(BUFFER_PIXELS * 2, MALLOC_CAP_8BIT));
+            dmaCapable = false;
+        }
+        if (!buf) return false;
+    }
+    dma_ = dmaCapable && tft.initDMA();
+    return dma_;
+}
+
+void LcdDma::beginBatch() {
+    if (depth_++ > 0) return;
+    // バッファはスワップ済みなので、転送中はそのまま送らせる
+    swapBytes_ = tft_->getSwapBytes();
+    tft_->setSwapBytes(false);
+    tft_->startWrite();
+}
+
+void LcdDma::endBatch() {
+    if (depth_ == 0 || --depth_ > 0) return;
+    wait();
+    tft_->endWrite();
+    tft_->setSwapBytes(swapBytes_);
+}
+
+// 実行中の DMA 転送が終わるまで待つ（待った時間を集計）
+void LcdDma::wait() {
+    if (!dma_ || !tft_->dmaBusy()) return;
+    uint32_t start = micros();
+    tft_->dmaWait();
+    frame_.waitMicros += micros() - start;
+}
+
+void LcdDma::beginCapture(uint16_t* frame, int width, int height) {
+    wait();  // 送りかけの矩形はパネルに出し切る
+    capture_ = frame;
+    captureWidth_ = width;
+    captureHeight_ = height;
+}
+
+void LcdDma::push(int32_t x, int32_t y, int32_t w, int32_t h) {
+    uint32_t pixels = static_cast<uint32_t>(w) * h;
+    if (pixels == 0 || pixels > BUFFER_PIXELS) return;
+    send(x, y, w, h, bufs_[cur_]);
+    // DMA で送っている面には書けないので、次はもう一方の面を埋める
+    if (dma_ && !capture_) cur_ ^= 1;
+}
+
+void LcdDma::pushPixels(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* pixels) {
+    if (w <= 0 || h <= 0 || !pixels) return;
+    send(x, y, w, h, pixels);
+}
+
+void LcdDma::send(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* src) {
+    if (capture_) {
+        // 画面外にはみ出す分は切り捨てて、オフスクリーン面に行ごとにコピーする
+        int32_t x0 = x < 0 ? 0 : x;
+        int32_t x1 = x + w > captureWidth_ ? captureWidth_ : x + w;
+        for (int32_t row = 0; row < h && x0 < x1; row++) {
+            int32_t py = y + row;
+            if (py < 0 || py >= captureHeight_) continue;
+            memcpy(capture_ + py * captureWidth_ + x0, src + row * w + (x0 - x), (x1 - x0) * sizeof(uint16_t));
+        }
+        return;
+    }
+    frame_.bytes += static_cast<uint32_t>(w) * h * 2;
+    frame_.pushes++;
+    if (dma_) {
+        wait();
+        // バッチ中は swapBytes が false なので、TFT_eSPI は画素を書き換えずに読むだけ
+        tft_->pushImageDMA(x, y, w, h, const_cast<uint16_t*>(src));
+    } else {
+        // 同期転送はその間 CPU が止まるので、全体を待ち時間に数える
+        uint32_t start = micros();
+        tft_->pushImage(x, y, w, h, src);
+        frame_.waitMicros += micros() - start;
+    }
+}
+
+void LcdDma::fill(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color) {
+    if (!ready() || w <= 0 || h <= 0) return;
+    if (capture_) {
+        const uint16_t c = swap(color);
+        int32_t x0 = x < 0 ? 0 : x;
+        int32_t x1 = x + w > captureWidth_ ? captureWidth_ : x + w;
+        for (int32_t py = y < 0 ? 0 : y; py < y + h && py < captureHeight_ && x0 < x1; py++) {
+            uint16_t* dst = capture_ + py * captureWidth_;
+            for (int32_t px = x0; px < x1; px++) dst[px] = c;
+        }
+        return;
+    }
+    frame_.bytes += static_cast<uint32_t>(w) * h * 2;
+    frame_.pushes++;
+    // 同じ色を送るだけなのでバッファを使わず、1 つのウィンドウで送る（その間 CPU は止まる）
+    wait();
+    uint32_t start = micros();
+    tft_->fillRect(x, y, w, h, color);
+    frame_.waitMicros += micros() - start;
+}
+
+void LcdDma::beginFrame() {
+    frame_ = FrameStats();
+    frameStart_ = micros();
+}
+
+const LcdDma::FrameStats& LcdDma::endFrame() {
+    wait();
+    frame_.totalMicros = micros() - frameStart_;
+    frame_.spiMicros = static_cast<uint32_t>(static_cast<uint64_t>(frame_.bytes) * 8 * 1000000 / SPI_HZ);
+    return frame_;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <TFT_eSPI.h>
+
+/**
+ * @brief TFT への DMA 転送をピンポン（2 面）バッファで行うクラス
+ *
+ * 描画側は buffer() に RGB565 の画素を書き、push() で矩形として送る。
+ * push() は DMA 転送を始めてすぐ戻り、次の buffer() はもう一方の面を返すので、
+ * 片方を SPI で送っている間にもう片方を CPU で埋められる。
+ * DMA 転送は同時に 1 つなので、push() は前の転送の完了を待ってから始める
+ * （そのとき前の面は空くので、次にまた埋めてよい）。
+ *
+ * バッファの画素はパネルに送る順（バイトスワップ済み）で書く（swap() を使う）。
+ * push() は必ず beginBatch() / endBatch() の中で呼ぶ。入れ子にしてよく、一番外側の
+ * endBatch() で転送の完了を待ってから SPI を手放すので、その後は通常の tft の
+ * 描画を混ぜてよい。DMA を初期化できなかった場合は pushImage で同期して送る。
+ *
+ * beginCapture() 中は push() した矩形をパネルに送らず、画面 1 枚分のメモリ
+ * （FrameComposer のオフスクリーン面）に書き込む。
+ *
+ * beginFrame() / endFrame() の間の、CPU が描画データを作っていた時間と
+ * SPI 転送を待っていた時間の内訳を FrameStats に集計する。
+ */
+class LcdDma {
+public:
+    static constexpr size_t BUFFER_PIXELS = 2048;   // 1 面 4KB
+
+    struct FrameStats {
+        uint32_t totalMicros = 0;   // beginFrame() から endFrame() まで
+        uint32_t waitMicros = 0;    // 転送の完了を待っていた時間（CPU が止まっていた）
+        uint32_t spiMicros = 0;     // 転送にかかった時間（バイト数と SPI クロックからの見積もり）
+        uint32_t bytes = 0;         // パネルに送ったバイト数（キャプチャ分は含まない）
+        uint32_t pushes = 0;
+        // CPU が描画データを作っていた時間
+        uint32_t cpuMicros() const { return totalMicros > waitMicros ? totalMicros - waitMicros : 0; }
+    };
+
+    LcdDma() = default;
+    ~LcdDma();
+    LcdDma(const LcdDma&) = delete;
+    LcdDma& operator=(const LcdDma&) = delete;
+
+    // tft.init() の後に呼ぶ。戻り値は DMA が使えるか（使えなくても同期転送で描画できる）
+    bool begin(TFT_eSPI &tft);
+    bool dmaEnabled() const { return dma_; }
+    // バッファを確保できた（描画できる）
+    bool ready() const { return bufs_[1] != nullptr; }
+
+    void beginBatch();
+    void endBatch();
+
+    // 次に埋める面（BUFFER_PIXELS 画素）
+    uint16_t* buffer() { return bufs_[cur_]; }
+    // buffer() に書いた w*h 画素を (x, y) に送る（w*h <= BUFFER_PIXELS）
+    void push(int32_t x, int32_t y, int32_t w, int32_t h);
+    // 呼び出し側が持つ画素（スワップ済み、DMA で読めるメモリ）をコピーせずに送る。
+    // 転送が終わるまで pixels を書き換えないこと（展開済みタイルのキャッシュ用）
+    void pushPixels(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* pixels);
+    // (x, y, w, h) を color で塗る（fillRect で 1 回の転送にする）
+    void fill(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color);
+
+    // push() の行き先を frame（width x height、スワップ済み RGB565）にする／パネルに戻す
+    void beginCapture(uint16_t* frame, int width, int height);
+    void endCapture() { capture_ = nullptr; }
+    bool capturing() const { return capture_ != nullptr; }
+
+    void beginFrame();
+    const FrameStats& endFrame();
+    const FrameStats& frameStats() const { return frame_; }
+
+    static uint16_t swap(uint16_t color) { return (color << 8) | (color >> 8); }
+
+private:
+    void wait();
+    // pixels を送る。送り終わるまで待たないので、戻った後も pixels は転送中
+    void send(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* pixels);
+
+    TFT_eSPI* tft_ = nullptr;
+    bool dma_ = false;
+    bool swapBytes_ = false;     // beginBatch() 前の setSwapBytes の値
+    int depth_ = 0;
+    uint16_t* bufs_[2] = {nullptr, nullptr};
+    int cur_ = 0;
+    uint16_t* capture_ = nullptr;
+    int captureWidth_ = 0;
+    int captureHeight_ = 0;
+    uint32_t frameStart_ = 0;
+    FrameStats frame_;
+};
+
+extern LcdDma lcdDma;
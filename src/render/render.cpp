@@ -0,0 +1,106 @@
+#include "render/render.h"
+#include "render/lcd_dma.h"
+#include <Arduino.h>
+
+int RenderEngine::addRegion(const char* name, int16_t x, int16_t y, int16_t w, int16_t h, uint8_t layer,
+                            DrawFn draw, void* ctx) {
+    if (count_ >= MAX_REGIONS || w <= 0 || h <= 0 || !draw) return -1;
+    regions_[count_] = { name, x, y, w, h, layer, draw, ctx, 0, true };
+    return count_++;
+}
+
+const char* RenderEngine::regionName(int id) const {
+    return id >= 0 && id < count_ ? regions_[id].name : "";
+}
+
+void RenderEngine::setContent(int id, uint32_t hash) {
+    if (id < 0 || id >= count_) return;
+    Region &r = regions_[id];
+    if (r.hash != hash) r.dirty = true;
+    r.hash = hash;
+}
+
+void RenderEngine::setBackground(uint16_t color) {
+    if (color == background_) return;
+    background_ = color;
+    invalidate();
+}
+
+void RenderEngine::invalidate() {
+    for (int i = 0; i < count_; i++) regions_[i].dirty = true;
+}
+
+uint32_t RenderEngine::hash(const void* data, size_t len, uint32_t seed) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint32_t h = seed;
+    for (size_t i = 0; i < len; i++) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+bool RenderEngine::overlaps(const Region &a, const Region &b) {
+    return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+bool RenderEngine::before(const Region &a, const Region &b) {
+    if (a.layer != b.layer) return a.layer < b.layer;
+    if (a.y != b.y) return a.y < b.y;
+    return a.x < b.x;
+}
+
+const RenderEngine::Stats& RenderEngine::render() {
+    uint32_t start = micros();
+    last_ = Stats();
+    last_.regions = count_;
+
+    // 描き直す領域に重なる同じ層・上の層の領域も描き直す（増えなくなるまで）
+    bool grown = true;
+    while (grown) {
+        grown = false;
+        for (int i = 0; i < count_; i++) {
+            if (!regions_[i].dirty) continue;
+            for (int j = 0; j < count_; j++) {
+                Region &r = regions_[j];
+                if (r.dirty || r.layer < regions_[i].layer || !overlaps(regions_[i], r)) continue;
+                r.dirty = true;
+                grown = true;
+            }
+        }
+    }
+
+    // 描く順に並べる（領域は高々 MAX_REGIONS なので挿入ソート）
+    int order[MAX_REGIONS];
+    int n = 0;
+    for (int i = 0; i < count_; i++) {
+        if (!regions_[i].dirty) continue;
+        int k = n++;
+        while (k > 0 && before(regions_[i], regions_[order[k - 1]])) {
+            order[k] = order[k - 1];
+            k--;
+        }
+        order[k] = i;
+    }
+
+    // 層ごとに、先に描き直す領域をすべて背景色で塗ってから描く
+    // （同じ層で重なる領域の塗りが、先に描いた隣の領域を消さないように）
+    lcdDma.beginBatch();
+    for (int k = 0; k < n;) {
+        int end = k;
+        while (end < n && regions_[order[end]].layer == regions_[order[k]].layer) end++;
+        for (int i = k; i < end; i++) {
+            const Region &r = regions_[order[i]];
+            lcdDma.fill(r.x, r.y, r.w, r.h, background_);
+        }
+        for (int i = k; i < end; i++) {
+            Region &r = regions_[order[i]];
+            r.draw(r.ctx);
+            r.dirty = false;
+            last_.repainted++;
+            last_.changedMask |= 1u << order[i];
+            last_.pixels += static_cast<uint32_t>(r.w) * r.h;
+        }
+        k = end;
+    }
+    lcdDma.endBatch();
+    last_.micros = micros() - start;
+    return last_;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief 画面を領域（矩形）の集まりとして持ち、内容が変わった領域だけを描き直すレンダラ
+ *
+ * 画面の部品（マップの枠、スプライト、名前、図鑑番号、説明文など）を addRegion() で
+ * 登録しておき、表示するたびに setContent() で内容のハッシュを渡す。render() は
+ * ハッシュが変わった領域だけを背景色で塗ってから描画関数を呼ぶ（同じ層の領域は
+ * まとめて塗ってから順に描くので、重なっていても画面全体を消して描くのと同じになる）。
+ *
+ * 領域には層（layer）があり、描き直した領域と重なる同じ層・上の層の領域も一緒に
+ * 描き直す（下の層は描き直さないので、上の層の領域は下の層の空白の上に置く）。
+ * 描き直す領域は層ごとに上から下・左から右の順に並べて描くので、パネルへの
+ * 書き込み（アドレスウィンドウの切り替え）は画面の上から順に進む。
+ *
+ * 描画は LcdDma を通すので、FrameComposer の合成中はオフスクリーン面に描かれる。
+ * レンダラを通さずにパネルへ描いたときは invalidate() で次に全部描き直させる。
+ */
+class RenderEngine {
+public:
+    static constexpr int MAX_REGIONS = 16;
+
+    typedef void (*DrawFn)(void* ctx);
+
+    struct Stats {
+        uint32_t regions = 0;      // 登録されている領域の数
+        uint32_t repainted = 0;    // 描き直した領域の数
+        uint32_t changedMask = 0;  // 描き直した領域（bit = 領域の番号）
+        uint32_t pixels = 0;       // 描き直した面積
+        uint32_t micros = 0;
+    };
+
+    // 領域を登録して番号を返す（いっぱいなら -1）。name はログ用で、文字列は保持したままにする
+    int addRegion(const char* name, int16_t x, int16_t y, int16_t w, int16_t h, uint8_t layer,
+                  DrawFn draw, void* ctx);
+    const char* regionName(int id) const;
+
+    // 領域の内容のハッシュを渡す。前回と違えば次の render() で描き直す
+    void setContent(int id, uint32_t hash);
+    // 領域を塗る色。変わったら全部描き直す
+    void setBackground(uint16_t color);
+    void invalidate();
+
+    // 変わった領域を描き直す
+    const Stats& render();
+    const Stats& lastRender() const { return last_; }
+
+    // 内容のハッシュ（FNV-1a）。seed に前の結果を渡すと続けて混ぜられる
+    static uint32_t hash(const void* data, size_t len, uint32_t seed = 2166136261u);
+
+private:
+    struct Region {
+        const char* name;
+        int16_t x, y, w, h;
+        uint8_t layer;
+        DrawFn draw;
+        void* ctx;
+        uint32_t hash;
+        bool dirty;
+    };
+
+    static bool overlaps(const Region &a, const Region &b);
+    // 描く順（層、上から、左から）
+    static bool before(const Region &a, const Region &b);
+
+    Region regions_[MAX_REGIONS];
+    int count_ = 0;
+    uint16_t background_ = 0;
+    Stats last_;
+};
+
+extern RenderEngine renderEngine;
@@ -0,0 +1,28 @@
+#include "render/text_layout.h"
+
+bool TextCursor::place(uint8_t code, int &x, int &y) {
+    if (full()) return false;
+    if (code == 0x4E || code == 0x4F) {
+        column_ = 0;
+        row_++;
+        return false;
+    }
+    // 行が埋まっていれば、次の文字（空白も）は次の行の先頭に置く。
+    // 最後の行なら置かずに終える（x() は最後の文字の後ろのまま）
+    if (column_ >= box_.columns) {
+        if (row_ + 1 >= box_.rows) {
+            row_ = box_.rows;
+            return false;
+        }
+        column_ = 0;
+        row_++;
+    }
+    if (code == 0x7F) {
+        column_++;
+        return false;
+    }
+    x = box_.x + column_ * box_.advance();
+    y = box_.y + row_ * box_.lineHeight();
+    column_++;
+    return true;
+}
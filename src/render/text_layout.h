@@ -0,0 +1,52 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * @brief ROM の文字コード列を並べる枠
+ *
+ * 1 文字は上文字（濁点・半濁点）の段とベース文字の段を合わせた 8x16 を scale 倍した大きさで、
+ * (x, y) から右へ advance() ずつ並べる。columns 文字で折り返し、rows 行を超えた文字は置かない。
+ * 上文字の無い文字列（数字）は accents を false にすると上文字の段を描かず、枠もベース文字の段だけになる。
+ *
+ * left() / top() / width() / height() は置いた文字が描く画素をすべて含む最小の矩形なので、
+ * そのまま RenderEngine の領域にする（描画と領域が同じ値から決まる）。
+ */
+struct TextBox {
+    int16_t x, y;       // 1 文字目の上文字の段の左上
+    uint8_t scale;
+    uint8_t spacing;    // 文字と文字、行と行の間
+    uint8_t columns;    // 1 行の文字数
+    uint8_t rows;
+    bool accents;
+
+    int advance() const { return 8 * scale + spacing; }
+    int lineHeight() const { return 16 * scale + spacing; }
+
+    int16_t left() const { return x; }
+    int16_t top() const { return y + (accents ? 0 : 8 * scale); }
+    int16_t width() const { return columns * advance() - spacing; }
+    int16_t height() const { return rows * lineHeight() - spacing - (accents ? 0 : 8 * scale); }
+    int16_t right() const { return left() + width(); }
+};
+
+/**
+ * @brief TextBox に文字コードを 1 つずつ置いていく
+ *
+ * 0x4E / 0x4F は改行、0x7F は空白（1 文字分進める）。そのほかのコードは次の升目に置く。
+ */
+class TextCursor {
+public:
+    explicit TextCursor(const TextBox &box) : box_(box) {}
+
+    // code を置く。文字を描くなら true を返し、(x, y) にその文字の上文字の段の左上を入れる
+    bool place(uint8_t code, int &x, int &y);
+    // 次の文字を置く x（最後の文字の後ろの間隔を含む。枠が埋まったら最後に置いた文字の後ろ）
+    int x() const { return box_.x + column_ * box_.advance(); }
+    // 枠の最後の行を越えた（以降の文字は置かない）
+    bool full() const { return row_ >= box_.rows; }
+
+private:
+    const TextBox &box_;
+    int column_ = 0;
+    int row_ = 0;
+};
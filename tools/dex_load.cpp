@@ -0,0 +1,107 @@
+// 図鑑 1 画面分の読み込み（loadDexScreenData）の時間をホストで測るツール
+//
+//   g++ -std=c++17 -O2 -I../src dex_load.cpp ../src/data/dex_screen.cpp ../src/data/pokemon_util.cpp ../src/data/pokemon_sprite.cpp ../src/data/rom_util.cpp ../src/data/PicUncompress.cpp ../src/data/rom_image.cpp ../src/data/rom_cache.cpp ../src/data/rom_index.cpp ../src/data/rom_profile.cpp ../src/data/sprite_atlas.cpp -o dex_load
+//   ./dex_load pokemon_blue.gb [rounds=20] 2>/dev/null
+//
+// 実機と同じ手順で索引を作り、151 画面を次の読み方で rounds 回ずつ読み込んで、
+// 1 画面あたりの平均・最大と ROM キャッシュのヒット率を表示する。
+//   mapped : ROM 全体をマップ（実機の ROM パーティション相当）
+//   file   : ファイルから都度読む（LittleFS 相当）
+//   cached : file + ページキャッシュ（実機の設定 256 バイト x 32）
+//   atlas  : mapped + 展開済みスプライトのアトラス（作業ディレクトリに dex_load.spr を作る）
+// ログ（索引作成の各行など）は stderr に出る。実機での時間は Serial の 'b' コマンドで測る。
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "data/dex_screen.h"
+#include "data/pokemon_util.h"
+#include "data/rom_image.h"
+#include "data/rom_index.h"
+#include "data/rom_profile.h"
+#include "data/rom_util.h"
+#include "data/sprite_atlas.h"
+
+namespace {
+
+double microsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+void measure(const char* name, RomImage &rom, const RomIndex &index, int rounds, SpriteAtlas* atlas = nullptr) {
+    static DexScreenData data;
+    double total = 0, worst = 0;
+    int screens = 0, failures = 0;
+    rom.resetCacheStats();
+    for (int round = 0; round < rounds; round++) {
+        for (uint8_t dex = 1; dex <= RomIndex::MAX_DEX; dex++) {
+            const PokemonLocation* loc = index.find(dex);
+            if (!loc) continue;
+            auto start = std::chrono::steady_clock::now();
+            bool ok = loadDexScreenData(rom, *loc, dex, data, atlas);
+            double us = microsSince(start);
+            total += us;
+            if (us > worst) worst = us;
+            screens++;
+            if (!ok) failures++;
+        }
+    }
+    const RomPageCache::Stats &st = rom.cacheStats();
+    uint32_t lookups = st.hits + st.misses;
+    std::printf("%-7s %8.1f us/screen  max %8.1f us  failures %d", name, screens ? total / screens : 0.0, worst,
+                failures);
+    if (lookups) std::printf("  cache hit %.1f%%", 100.0 * st.hits / lookups);
+    std::printf("\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <rom.gb> [rounds=20]\n", argv[0]);
+        return 1;
+    }
+    const std::string romPath = argv[1];
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 20;
+
+    RomImage mapped;
+    if (!mapped.openMapped(romPath)) {
+        std::fprintf(stderr, "cannot open %s\n", romPath.c_str());
+        return 1;
+    }
+    RomIdentity id;
+    const RomProfile* profile = identifyRom(mapped, "", id) ? findRomProfile(id) : nullptr;
+    if (!profile) {
+        std::fprintf(stderr, "unknown ROM: %s\n", id.header.title);
+        return 1;
+    }
+
+    // 起動時と同じ手順で索引を作る
+    std::vector<uint8_t> indexToDex = readROMData(mapped, profile->indexToDex, profile->indexToDexLength);
+    RomIndex index;
+    if (!buildRomIndex(mapped, *profile, buildDexToIndex(indexToDex), index)) {
+        std::fprintf(stderr, "index incomplete\n");
+    }
+    std::printf("%s (%s), %d rounds x 151 screens\n", id.header.title, profile->name, rounds);
+
+    measure("mapped", mapped, index, rounds);
+
+    RomImage file;
+    if (!file.open(romPath)) return 1;
+    measure("file", file, index, rounds);
+
+    RomImage cached;
+    if (!cached.open(romPath) || !cached.enableCache(256, 32)) return 1;
+    measure("cached", cached, index, rounds);
+
+    const char* atlasPath = "dex_load.spr";
+    RomIndexKey key;
+    SpriteAtlas atlas;
+    if (RomIndexKey::fromRom(mapped, key) && SpriteAtlas::build(mapped, index, atlasPath) &&
+        atlas.open(atlasPath, key)) {
+        measure("atlas", mapped, index, rounds, &atlas);
+    } else {
+        std::fprintf(stderr, "cannot build %s\n", atlasPath);
+    }
+    return 0;
+}
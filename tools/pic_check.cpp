@@ -0,0 +1,187 @@
+// ROM の全スプライトで PicDecoder を検査し、展開速度を測るホスト用ツール
+//
+//   g++ -std=c++17 -O2 -I../src pic_check.cpp ../src/data/PicUncompress.cpp ../src/data/rom_image.cpp ../src/data/rom_cache.cpp ../src/data/rom_profile.cpp -o pic_check
+//   ./pic_check pokemon_blue.gb [hashes.txt]
+//
+// 151 匹のスプライトを展開し、参照デコーダ（pic_reference.h）と出力・使用バイト数を
+// スプライトごとにビット単位で比べる。参照デコーダのデルタ復号と XOR 合成は表引きにする前の
+// 実装（codes[bit][nybble] を 1 nybble ずつ、carry を順に渡す）と同じなので、
+// PicDecoder の表引き（deltaColumn / xorColumn）の検査にもなる。
+// hashes.txt があれば各スプライトの出力ハッシュと照合し、無ければ今回の結果で作る
+// （最適化の前に作っておき、後で一致を確かめる）。
+// 最後に全スプライトを繰り返し展開して sprites/s と MB/s（圧縮側・展開側）を表示する。
+// 実機での速度は Serial の 'd' コマンドで測る。
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "data/PicUncompress.h"
+#include "data/rom_image.h"
+#include "data/rom_profile.h"
+#include "pic_reference.h"
+
+namespace {
+
+struct Sprite {
+    int dex;
+    const uint8_t* data;   // マップした ROM 上の圧縮データ
+    size_t limit;          // バンク末尾までの長さ
+    size_t length;         // 実際に使った長さ
+    int width;
+    uint64_t hash;
+};
+
+uint64_t fnv1a(const uint8_t* data, size_t len) {
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < len; i++) {
+        h ^= data[i];
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// hashes.txt の 1 行: "dex width length hash"
+bool loadHashes(const char* path, std::vector<Sprite> &expect) {
+    FILE* f = std::fopen(path, "r");
+    if (!f) return false;
+    Sprite s = {};
+    unsigned long long hash;
+    while (std::fscanf(f, "%d %d %zu %llx", &s.dex, &s.width, &s.length, &hash) == 4) {
+        s.hash = hash;
+        expect.push_back(s);
+    }
+    std::fclose(f);
+    return true;
+}
+
+bool saveHashes(const char* path, const std::vector<Sprite> &sprites) {
+    FILE* f = std::fopen(path, "w");
+    if (!f) return false;
+    for (const Sprite &s : sprites) {
+        std::fprintf(f, "%d %d %zu %016llx\n", s.dex, s.width, s.length, (unsigned long long)s.hash);
+    }
+    return std::fclose(f) == 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <rom.gb> [hashes.txt]\n", argv[0]);
+        return 1;
+    }
+    RomImage rom;
+    if (!rom.openMapped(argv[1])) {
+        std::fprintf(stderr, "cannot open %s\n", argv[1]);
+        return 1;
+    }
+    RomIdentity id;
+    const RomProfile* profile = identifyRom(rom, "", id) ? findRomProfile(id) : nullptr;
+    if (!profile) {
+        std::fprintf(stderr, "unknown ROM: %s\n", id.header.title);
+        return 1;
+    }
+
+    // Index番号 → 図鑑番号 の逆引き
+    std::vector<uint8_t> indexToDex(profile->indexToDexLength);
+    rom.read(profile->indexToDex, indexToDex.data(), indexToDex.size());
+    int dexToIndex[152];
+    for (int &i : dexToIndex) i = -1;
+    for (size_t i = 0; i < indexToDex.size(); i++) {
+        if (indexToDex[i] >= 1 && indexToDex[i] <= 151) dexToIndex[indexToDex[i]] = i;
+    }
+
+    static PicDecoder::Scratch scratch;
+    PicDecoder decoder(scratch);
+    uint8_t out[PicDecoder::OUTPUT_MAX];
+    std::vector<uint8_t> expect;
+    std::vector<Sprite> sprites;
+    int errors = 0;
+
+    for (int dex = 1; dex <= 151; dex++) {
+        uint32_t offset = dexToIndex[dex] < 0 ? 0 : pokemonSpriteOffset(rom, *profile, dex, dexToIndex[dex]);
+        uint32_t bankEnd = (offset / RomImage::BANK_SIZE + 1) * RomImage::BANK_SIZE;
+        Sprite s = { dex, rom.mapped(offset, bankEnd - offset), bankEnd - offset, 0, 0, 0 };
+        if (!offset || !s.data) {
+            std::printf("dex %3d: sprite not found\n", dex);
+            errors++;
+            continue;
+        }
+        int n = decoder.decode(s.data, s.limit, out, sizeof(out));
+        size_t refLength = 0;
+        int refN = picref::decode(s.data, s.limit, expect, &refLength);
+        if (n <= 0 || n != refN || std::memcmp(out, expect.data(), n) != 0 ||
+            decoder.consumedBytes() != refLength) {
+            // 最初に違うバイト（出力はスキャンライン順。行 = byte / (width*2)）
+            int first = -1;
+            for (int i = 0; n > 0 && i < n && i < refN; i++) {
+                if (out[i] != expect[i]) {
+                    first = i;
+                    break;
+                }
+            }
+            std::printf("dex %3d: 0x%06X decode mismatch (%d / reference %d, first diff %d, length %zu / %zu)\n",
+                        dex, offset, n, refN, first, decoder.consumedBytes(), refLength);
+            errors++;
+            continue;
+        }
+        s.length = decoder.consumedBytes();
+        s.width = decoder.width();
+        s.hash = fnv1a(out, n);
+        sprites.push_back(s);
+    }
+    std::printf("%zu sprites decoded, %d errors\n", sprites.size(), errors);
+
+    if (argc > 2) {
+        std::vector<Sprite> stored;
+        if (loadHashes(argv[2], stored)) {
+            int mismatches = 0;
+            for (const Sprite &e : stored) {
+                const Sprite* s = nullptr;
+                for (const Sprite &c : sprites) {
+                    if (c.dex == e.dex) s = &c;
+                }
+                if (!s || s->width != e.width || s->length != e.length || s->hash != e.hash) {
+                    std::printf("dex %3d: hash mismatch\n", e.dex);
+                    mismatches++;
+                }
+            }
+            std::printf("%zu hashes checked, %d mismatches\n", stored.size(), mismatches);
+            errors += mismatches;
+        } else if (saveHashes(argv[2], sprites)) {
+            std::printf("wrote %s\n", argv[2]);
+        } else {
+            std::fprintf(stderr, "cannot write %s\n", argv[2]);
+            return 1;
+        }
+    }
+    if (sprites.empty()) return 1;
+
+    // 全スプライトの展開を 1 秒以上繰り返す
+    size_t inBytes = 0, outBytes = 0;
+    for (const Sprite &s : sprites) {
+        inBytes += s.length;
+        outBytes += s.width * s.width * 16;
+    }
+    for (int pass = 0; pass < 2; pass++) {
+        const char* name = pass == 0 ? "PicDecoder" : "reference ";
+        long rounds = 0;
+        auto start = std::chrono::steady_clock::now();
+        double elapsed = 0;
+        do {
+            for (const Sprite &s : sprites) {
+                if (pass == 0) decoder.decode(s.data, s.length, out, sizeof(out));
+                else picref::decode(s.data, s.length, expect);
+            }
+            rounds++;
+        } while ((elapsed = secondsSince(start)) < 1.0);
+        double count = double(rounds) * sprites.size();
+        std::printf("%s: %.0f sprites/s, in %.2f MB/s, out %.2f MB/s\n", name, count / elapsed,
+                    rounds * inBytes / elapsed / 1e6, rounds * outBytes / elapsed / 1e6);
+    }
+    return errors ? 1 : 0;
+}
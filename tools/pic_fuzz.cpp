@@ -0,0 +1,161 @@
+// PicDecoder の差分ファジング（ホスト用ツール）
+//
+// 1 つの入力を次の方法で展開し、結果がすべて一致することを確かめる。
+//   - 参照デコーダ（pic_reference.h）
+//   - PicDecoder::decode(data, len)
+//   - PicDecoder::decode(InputFetch) を入力から決めた細切れの読み出しで
+//   - タイル列コールバック付き（列が左から 1 回ずつ通知され、その時点で列が確定していること）
+// 不一致やメモリ破壊は abort する。
+//
+// libFuzzer + ASan:
+//   clang++ -std=c++17 -g -O1 -fsanitize=fuzzer,address,undefined -I../src pic_fuzz.cpp ../src/data/PicUncompress.cpp -o pic_fuzz
+//   ./pic_fuzz corpus/
+// libFuzzer が無い環境（g++）ではランダム入力で回す:
+//   g++ -std=c++17 -g -O1 -fsanitize=address,undefined -DPIC_FUZZ_STANDALONE -I../src pic_fuzz.cpp ../src/data/PicUncompress.cpp -o pic_fuzz
+//   ./pic_fuzz [iterations=200000] [seed=1]    または  ./pic_fuzz file...
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "data/PicUncompress.h"
+#include "pic_reference.h"
+
+namespace {
+
+void check(bool ok, const char* what) {
+    if (ok) return;
+    std::fprintf(stderr, "mismatch: %s\n", what);
+    std::abort();
+}
+
+// 入力を毎回 chunk バイトずつしか返さない InputFetch
+struct ChunkFetch {
+    const uint8_t* data;
+    size_t len;
+    size_t chunk;
+};
+
+size_t fetchChunk(uint32_t offset, uint8_t* dst, size_t len, void* ctx) {
+    ChunkFetch* f = static_cast<ChunkFetch*>(ctx);
+    if (offset >= f->len) return 0;
+    size_t n = f->len - offset;
+    if (n > len) n = len;
+    if (n > f->chunk) n = f->chunk;
+    std::memcpy(dst, f->data + offset, n);
+    return n;
+}
+
+// 通知された列がその時点で最終結果と同じになっているかは、展開後に写しと比べる
+struct ColumnLog {
+    int next = 0;
+    bool ordered = true;
+    uint8_t snapshot[PicDecoder::OUTPUT_MAX];
+};
+
+void onColumn(int tc, int width, const uint8_t* out, void* ctx) {
+    ColumnLog* log = static_cast<ColumnLog*>(ctx);
+    if (tc != log->next++ || tc >= width) {
+        log->ordered = false;
+        return;
+    }
+    for (int r = 0; r < width * 8; r++) {
+        size_t i = (r * width + tc) * 2;
+        log->snapshot[i] = out[i];
+        log->snapshot[i + 1] = out[i + 1];
+    }
+}
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    // 入力ちょうどの長さのヒープ領域に置き、末尾を越えた読み出しを ASan で捕まえる
+    std::vector<uint8_t> input(data, data + size);
+
+    std::vector<uint8_t> expect;
+    size_t expectConsumed = 0;
+    int expectSize = picref::decode(input.data(), input.size(), expect, &expectConsumed);
+
+    static PicDecoder::Scratch scratch;
+    PicDecoder decoder(scratch);
+    uint8_t out[PicDecoder::OUTPUT_MAX];
+
+    int n = decoder.decode(input.data(), input.size(), out, sizeof(out));
+    check(n == expectSize, "memory decode result");
+    if (n > 0) {
+        check(std::memcmp(out, expect.data(), n) == 0, "memory decode output");
+        check(decoder.consumedBytes() == expectConsumed, "memory decode consumedBytes");
+    }
+
+    // 出力先が 1 バイト足りなければ必ず失敗する
+    if (expectSize > 0) {
+        check(decoder.decode(input.data(), input.size(), out, expectSize - 1) == -1, "short output buffer");
+    }
+
+    ChunkFetch fetch = { input.data(), input.size(), size ? 1 + input[size - 1] % PicDecoder::WINDOW_SIZE : 1 };
+    ColumnLog log;
+    std::memset(out, 0, sizeof(out));
+    n = decoder.decode(fetchChunk, &fetch, out, sizeof(out), onColumn, &log);
+    check(n == expectSize, "fetch decode result");
+    if (n > 0) {
+        check(std::memcmp(out, expect.data(), n) == 0, "fetch decode output");
+        check(decoder.consumedBytes() == expectConsumed, "fetch decode consumedBytes");
+        check(log.ordered && log.next == decoder.width(), "column callback order");
+        check(std::memcmp(log.snapshot, expect.data(), n) == 0, "column callback contents");
+    }
+    return 0;
+}
+
+#ifdef PIC_FUZZ_STANDALONE
+#include <random>
+
+static bool readAll(const char* path, std::vector<uint8_t> &out) {
+    FILE* f = std::fopen(path, "rb");
+    if (!f) return false;
+    std::fseek(f, 0, SEEK_END);
+    out.resize(std::ftell(f));
+    std::fseek(f, 0, SEEK_SET);
+    bool ok = std::fread(out.data(), 1, out.size(), f) == out.size();
+    std::fclose(f);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    // ファイル指定時はそれぞれを 1 入力として流す（libFuzzer のクラッシュ入力の再現用）
+    if (argc > 1 && std::atol(argv[1]) == 0) {
+        for (int i = 1; i < argc; i++) {
+            std::vector<uint8_t> data;
+            if (!readAll(argv[i], data)) {
+                std::fprintf(stderr, "cannot read %s\n", argv[i]);
+                return 1;
+            }
+            LLVMFuzzerTestOneInput(data.data(), data.size());
+        }
+        std::printf("%d files ok\n", argc - 1);
+        return 0;
+    }
+
+    long iterations = argc > 1 ? std::atol(argv[1]) : 200000;
+    std::mt19937 rng(argc > 2 ? std::atoi(argv[2]) : 1);
+    std::vector<uint8_t> data;
+    long decoded = 0;
+    for (long it = 0; it < iterations; it++) {
+        // 正しいヘッダ + 偏ったビット列にして、展開まで進む入力を増やす
+        data.resize(rng() % 800);
+        int density = rng() % 5;
+        for (uint8_t &b : data) {
+            uint32_t v = rng();
+            for (int k = 0; k < density; k++) v &= rng();
+            b = static_cast<uint8_t>(v);
+        }
+        if (!data.empty() && rng() % 8) {
+            int w = 1 + rng() % 7;
+            data[0] = (w << 4) | w;
+        }
+        std::vector<uint8_t> expect;
+        if (picref::decode(data.data(), data.size(), expect) > 0) decoded++;
+        LLVMFuzzerTestOneInput(data.data(), data.size());
+    }
+    std::printf("%ld inputs ok (%ld decoded)\n", iterations, decoded);
+    return 0;
+}
+#endif
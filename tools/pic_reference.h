@@ -0,0 +1,132 @@
+// PicDecoder と比べるための参照デコーダ（ホスト用ツール専用）
+//
+// 元の uncompress() と同じ手順（1 ビットずつ読む → 2bit グループのプレーン →
+// 4 行ずつ詰める → Gray コード復号 → XOR 合成）をそのまま書き、
+// 速さより読みやすさを優先する。すべての添字を範囲内に収め、
+// 入力の末尾を越えて読んだ場合は失敗にする（PicDecoder と同じ扱い）。
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace picref {
+
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t len) : data_(data), len_(len) {}
+
+    int bit() {
+        size_t byte = pos_ >> 3;
+        int v = byte < len_ ? (data_[byte] >> (7 - (pos_ & 7))) & 1 : 0;
+        pos_++;
+        return v;
+    }
+    int bits(int count) {
+        int n = 0;
+        while (count--) n = (n << 1) | bit();
+        return n;
+    }
+    bool overrun() const { return pos_ > len_ * 8; }
+    size_t consumedBytes() const { return (pos_ + 7) / 8; }
+
+private:
+    const uint8_t* data_;
+    size_t len_;
+    size_t pos_ = 0;
+};
+
+// 1 枚のプレーンを読み、タイル列順（plane[tc * H + r]）の 1bpp にする
+inline bool fillPlane(BitReader &in, int width, std::vector<uint8_t> &out) {
+    static const int table[16] = {
+        0x0001,0x0003,0x0007,0x000F,0x001F,0x003F,0x007F,0x00FF,
+        0x01FF,0x03FF,0x07FF,0x0FFF,0x1FFF,0x3FFF,0x7FFF,0xFFFF
+    };
+    const int size = width * width * 0x20;   // 2bit グループの数
+    std::vector<uint8_t> groups(size, 0);
+    int mode = in.bit();
+    int len = 0;
+    while (len < size) {
+        if (mode) {
+            while (len < size) {
+                int group = in.bits(2);
+                if (!group) break;
+                groups[len++] = group;
+            }
+        } else {
+            int w = 0;
+            while (in.bit()) {
+                if (++w >= 16) return false;
+            }
+            long n = table[w] + in.bits(w + 1);
+            while (len < size && n--) groups[len++] = 0;
+        }
+        mode ^= 1;
+    }
+
+    // グループの行 r（W*4 行）を 4 行ずつ 1 バイトに詰める
+    out.assign(size / 4, 0);
+    for (int tc = 0; tc < width; tc++) {
+        for (int x = 0; x < width * 8; x++) {
+            uint8_t v = 0;
+            for (int i = 0; i < 4; i++) v = (v << 2) | groups[(tc * 4 + i) * width * 8 + x];
+            out[tc * width * 8 + x] = v;
+        }
+    }
+    return true;
+}
+
+// 行ごとに左のタイル列から右へ Gray コードを復号する。
+// 表引きにする前の PicDecoder（uncompress_plane）と同じく 1 nybble ずつ codes を引き、carry を順に渡す
+inline void deltaPlane(std::vector<uint8_t> &plane, int width) {
+    static const int codes[2][16] = {
+        {0x0,0x1,0x3,0x2,0x7,0x6,0x4,0x5,0xF,0xE,0xC,0xD,0x8,0x9,0xB,0xA},
+        {0xF,0xE,0xC,0xD,0x8,0x9,0xB,0xA,0x0,0x1,0x3,0x2,0x7,0x6,0x4,0x5}
+    };
+    const int height = width * 8;
+    for (int r = 0; r < height; r++) {
+        int bit = 0;
+        for (int tc = 0; tc < width; tc++) {
+            uint8_t &b = plane[tc * height + r];
+            int hi = codes[bit][b >> 4];
+            bit = hi & 1;
+            int lo = codes[bit][b & 0xF];
+            bit = lo & 1;
+            b = (hi << 4) | lo;
+        }
+    }
+}
+
+// PicDecoder::decode と同じ形式（スキャンライン順の 2bpp）で out に展開する。
+// 戻り値は出力バイト数、失敗時は -1。consumed には使った入力のバイト数を返す
+inline int decode(const uint8_t* data, size_t len, std::vector<uint8_t> &out, size_t* consumed = nullptr) {
+    BitReader in(data, len);
+    int width = in.bits(4);
+    if (in.bits(4) != width || width < 1 || width > 7) return -1;
+
+    std::vector<uint8_t> planes[2];
+    int order = in.bit();
+    if (!fillPlane(in, width, planes[order])) return -1;
+    int mode = in.bit();
+    if (mode) mode += in.bit();
+    if (!fillPlane(in, width, planes[order ^ 1])) return -1;
+    if (in.overrun()) return -1;
+
+    deltaPlane(planes[order], width);
+    if (mode != 1) deltaPlane(planes[order ^ 1], width);
+    if (mode != 0) {
+        for (size_t i = 0; i < planes[0].size(); i++) planes[order ^ 1][i] ^= planes[order][i];
+    }
+
+    const int height = width * 8;
+    out.assign(width * height * 2, 0);
+    for (int r = 0; r < height; r++) {
+        for (int tc = 0; tc < width; tc++) {
+            out[(r * width + tc) * 2 + 0] = planes[0][tc * height + r];
+            out[(r * width + tc) * 2 + 1] = planes[1][tc * height + r];
+        }
+    }
+    if (consumed) *consumed = in.consumedBytes();
+    return static_cast<int>(out.size());
+}
+
+}  // namespace picref
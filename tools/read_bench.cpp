@@ -0,0 +1,131 @@
+// readROMData（RomImage::readUntil）と以前の 1 バイトずつの読み出しを比べるホスト用ツール
+//
+//   g++ -std=c++17 -O2 -I../src read_bench.cpp ../src/data/rom_util.cpp ../src/data/pokemon_util.cpp ../src/data/pokemon_sprite.cpp ../src/data/PicUncompress.cpp ../src/data/rom_image.cpp ../src/data/rom_cache.cpp ../src/data/rom_index.cpp ../src/data/rom_profile.cpp -o read_bench
+//   ./read_bench pokemon_blue.gb 2>/dev/null
+//
+// 151 匹分の次の読み出しを、ファイルから読む RomImage（LittleFS 相当）とマップした RomImage で
+// それぞれ 1 秒ずつ繰り返し、bytes/s を表示する。
+//   name   : 名前（0x50 終端、最大 nameLength バイト）
+//   text   : 図鑑説明文（0x5F 終端、最大 256 バイト）
+//   sprite : 圧縮スプライト 700 バイト（終端なし）
+// 以前の読み出しは 1 バイトずつ read() し、終端と比べる窓を vector の erase でずらしていた。
+// 両方の結果が一致することも確かめる。
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "data/pokemon_util.h"
+#include "data/rom_image.h"
+#include "data/rom_index.h"
+#include "data/rom_profile.h"
+#include "data/rom_util.h"
+
+namespace {
+
+struct ReadCase {
+    const char* name;
+    std::vector<uint32_t> offsets;
+    size_t maxLength;
+    std::vector<uint8_t> stop;
+};
+
+// 以前の readROMData と同じ読み方
+std::vector<uint8_t> readByteLoop(RomImage &rom, uint32_t startAddr, size_t maxLength,
+                                  const std::vector<uint8_t> &stopSequence) {
+    std::vector<uint8_t> result;
+    std::vector<uint8_t> buffer;
+    size_t readCount = 0;
+    uint8_t byte;
+    while (readCount < maxLength && rom.read(startAddr + readCount, &byte, 1) == 1) {
+        result.push_back(byte);
+        readCount++;
+        if (!stopSequence.empty()) {
+            buffer.push_back(byte);
+            if (buffer.size() > stopSequence.size()) buffer.erase(buffer.begin());
+            if (buffer.size() == stopSequence.size()) {
+                bool match = true;
+                for (size_t i = 0; i < stopSequence.size(); i++) {
+                    if (buffer[i] != stopSequence[i]) { match = false; break; }
+                }
+                if (match) break;
+            }
+        }
+    }
+    return result;
+}
+
+// 全オフセットの読み出しを 1 秒以上繰り返し、bytes/s を返す
+template <typename Read>
+double bytesPerSecond(const ReadCase &c, Read read) {
+    size_t bytes = 0;
+    double elapsed = 0;
+    auto start = std::chrono::steady_clock::now();
+    do {
+        for (uint32_t offset : c.offsets) bytes += read(offset).size();
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < 1.0);
+    return bytes / elapsed;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <rom.gb>\n", argv[0]);
+        return 1;
+    }
+    RomImage mapped, file;
+    if (!mapped.openMapped(argv[1]) || !file.open(argv[1])) {
+        std::fprintf(stderr, "cannot open %s\n", argv[1]);
+        return 1;
+    }
+    RomIdentity id;
+    const RomProfile* profile = identifyRom(mapped, "", id) ? findRomProfile(id) : nullptr;
+    if (!profile) {
+        std::fprintf(stderr, "unknown ROM: %s\n", id.header.title);
+        return 1;
+    }
+    std::vector<uint8_t> indexToDex = readROMData(mapped, profile->indexToDex, profile->indexToDexLength);
+    RomIndex index;
+    buildRomIndex(mapped, *profile, buildDexToIndex(indexToDex), index);
+
+    ReadCase cases[] = {
+        { "name", {}, profile->nameLength, {0x50} },
+        { "text", {}, 256, {0x5F} },
+        { "sprite", {}, 700, {} },
+    };
+    for (uint8_t dex = 1; dex <= RomIndex::MAX_DEX; dex++) {
+        const PokemonLocation* loc = index.find(dex);
+        if (!loc) continue;
+        cases[0].offsets.push_back(loc->nameOffset);
+        cases[1].offsets.push_back(loc->textOffset);
+        cases[2].offsets.push_back(loc->spriteOffset);
+    }
+    if (cases[0].offsets.empty()) {
+        std::fprintf(stderr, "no dex entries found\n");
+        return 1;
+    }
+
+    int errors = 0;
+    for (const ReadCase &c : cases) {
+        for (uint32_t offset : c.offsets) {
+            if (readByteLoop(file, offset, c.maxLength, c.stop) != readROMData(file, offset, c.maxLength, c.stop)) {
+                std::printf("%s at 0x%06X: result mismatch\n", c.name, offset);
+                errors++;
+            }
+        }
+    }
+
+    std::printf("%zu entries, %d mismatches\n", cases[0].offsets.size(), errors);
+    std::printf("%-7s %-7s %14s %14s %8s\n", "read", "source", "byte loop B/s", "readUntil B/s", "speedup");
+    for (const ReadCase &c : cases) {
+        RomImage* sources[] = { &file, &mapped };
+        const char* sourceNames[] = { "file", "mapped" };
+        for (int s = 0; s < 2; s++) {
+            RomImage &rom = *sources[s];
+            double before = bytesPerSecond(c, [&](uint32_t o) { return readByteLoop(rom, o, c.maxLength, c.stop); });
+            double after = bytesPerSecond(c, [&](uint32_t o) { return readROMData(rom, o, c.maxLength, c.stop); });
+            std::printf("%-7s %-7s %14.0f %14.0f %7.1fx\n", c.name, sourceNames[s], before, after, after / before);
+        }
+    }
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,720 @@
+// LcdDma・FrameComposer・RenderEngine・マップ描画をホストで検査するツール
+//
+//   make render_check    （tools/Makefile。build/render_check を作って実行する）
+//
+// TFT_eSPI・Arduino・esp_heap_caps は render_stubs/ の代わりを使う。TFT_eSPI の代わりは描いた画素を
+// 残し、DMA の使い方の違反（転送中のほかの描画、転送中の送り元の書き換え、DMA で読めない
+// メモリからの転送など）を数える。どの検査も、描いた結果を画素ごとの参照と比べる。
+//   lcd_dma : push / pushPixels / fill、ピンポンの面の切り替え、キャプチャ（画面外の切り捨て）、
+//             DMA が使えないときの同期転送
+//   compose : オフスクリーン合成で送った画面が直接描いた画面と同じこと、変わらないフレームは送らないこと
+//   render  : RenderEngine の差分描画が毎回全部描き直した画面と同じこと（合成あり・なし）
+//   glyph   : drawFont8x8 の拡大（1 面に入らない倍率は行ごとに分けて送る、入らない倍率は描かない）
+//   dex     : 図鑑画面の配置（dex_layout.h）。文字と単位を描く範囲が領域の矩形に収まり、
+//             矩形がマップの枠のタイルに重ならず、文字を差し替えながらの差分描画が全部描き直した画面と同じこと
+//   map     : drawMap（タイルキャッシュ・スパン）が 1 タイルずつ描いた画面と同じこと
+//             （パレットの変更、タイルキャッシュを DMA で読めるメモリに置けないとき）
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <esp_heap_caps.h>
+#include "dex_layout.h"
+#include "map_draw.h"
+#include "render/frame_compose.h"
+#include "render/glyph.h"
+#include "render/lcd_dma.h"
+#include "render/render.h"
+#include "render/text_layout.h"
+
+// --- esp_heap_caps / Arduino の代わり ---
+namespace {
+
+struct Block {
+    const uint8_t* p;
+    size_t size;
+};
+std::vector<Block> dmaBlocks;   // DMA で読めるメモリ（MALLOC_CAP_DMA で確保したもの）
+bool refuseDma = false;         // MALLOC_CAP_DMA の確保を失敗させる
+
+bool isDmaCapable(const void* data, size_t bytes) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    for (const Block &b : dmaBlocks) {
+        if (p >= b.p && p + bytes <= b.p + b.size) return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+void* heap_caps_malloc(size_t size, uint32_t caps) {
+    if (refuseDma && (caps & MALLOC_CAP_DMA)) return nullptr;
+    void* p = std::malloc(size);
+    if (p && (caps & MALLOC_CAP_DMA)) dmaBlocks.push_back({ static_cast<uint8_t*>(p), size });
+    return p;
+}
+
+void heap_caps_free(void* ptr) {
+    for (size_t i = 0; i < dmaBlocks.size(); i++) {
+        if (dmaBlocks[i].p == ptr) {
+            dmaBlocks.erase(dmaBlocks.begin() + i);
+            break;
+        }
+    }
+    std::free(ptr);
+}
+
+unsigned long micros() {
+    static unsigned long now = 0;
+    return ++now;
+}
+
+// 終了時に heap_caps_free を呼ぶので dmaBlocks より後に置く
+TFT_eSPI tft;
+LcdDma lcdDma;
+FrameComposer frameComposer;
+
+namespace {
+
+constexpr int W = TFT_eSPI::WIDTH;
+constexpr int H = TFT_eSPI::HEIGHT;
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    if (ok) return;
+    std::printf("NG: %s\n", what);
+    failures++;
+}
+
+// 参照の画面（論理色）
+struct Surface {
+    uint16_t px[H][W];
+
+    void clear(uint16_t color) {
+        for (auto &row : px) {
+            for (auto &p : row) p = color;
+        }
+    }
+    void fill(int x, int y, int w, int h, uint16_t color) {
+        for (int j = y; j < y + h; j++) {
+            for (int i = x; i < x + w; i++) {
+                if (j >= 0 && j < H && i >= 0 && i < W) px[j][i] = color;
+            }
+        }
+    }
+    // スワップ済みの画素を置く
+    void blit(int x, int y, int w, int h, const uint16_t* swapped) {
+        for (int j = 0; j < h; j++) {
+            for (int i = 0; i < w; i++) {
+                if (y + j >= 0 && y + j < H && x + i >= 0 && x + i < W) px[y + j][x + i] = LcdDma::swap(swapped[j * w + i]);
+            }
+        }
+    }
+};
+
+Surface ref;
+
+bool panelIs(const TFT_eSPI &panel, const Surface &s) {
+    return std::memcmp(panel.fb, s.px, sizeof(s.px)) == 0;
+}
+
+// DMA の使い方の違反が無いこと
+void checkViolations(TFT_eSPI &panel, const char* what) {
+    if (panel.violations) {
+        std::printf("NG: %s: %ld DMA violations (%s)\n", what, panel.violations, panel.lastViolation);
+        failures++;
+        panel.violations = 0;
+    }
+}
+
+// パネルが参照と同じで、DMA の使い方の違反が無いこと
+void checkPanel(TFT_eSPI &panel, const char* what) {
+    check(panelIs(panel, ref), what);
+    checkViolations(panel, what);
+}
+
+// --- 描画の操作（LcdDma と参照の両方に同じものを描く） ---
+struct Op {
+    int kind;       // 0: fill, 1: push（LcdDma のバッファ）, 2: pushPixels（呼び出し側の画素）
+    int x, y, w, h;
+    uint16_t color;
+    uint32_t seed;
+};
+
+uint16_t pool[LcdDma::BUFFER_PIXELS];   // pushPixels の送り元（DMA で読めるメモリとして登録する）
+
+void pattern(uint16_t* dst, int n, uint32_t seed) {
+    for (int i = 0; i < n; i++) dst[i] = static_cast<uint16_t>((seed + i * 40503u) * 2654435761u >> 16);
+}
+
+Op randomOp(std::mt19937 &rng) {
+    Op op;
+    op.kind = rng() % 3;
+    op.w = 1 + rng() % 64;
+    int maxH = LcdDma::BUFFER_PIXELS / op.w;
+    op.h = 1 + rng() % (maxH < 64 ? maxH : 64);
+    op.x = rng() % (W - op.w + 1);
+    op.y = rng() % (H - op.h + 1);
+    op.color = rng();
+    op.seed = rng();
+    return op;
+}
+
+void draw(LcdDma &dma, const Op &op) {
+    if (op.kind == 0) {
+        dma.fill(op.x, op.y, op.w, op.h, op.color);
+    } else if (op.kind == 1) {
+        pattern(dma.buffer(), op.w * op.h, op.seed);
+        dma.push(op.x, op.y, op.w, op.h);
+    } else {
+        dma.pushPixels(op.x, op.y, op.w, op.h, pool + op.seed % (LcdDma::BUFFER_PIXELS - op.w * op.h + 1));
+    }
+}
+
+void drawRef(Surface &s, const Op &op) {
+    if (op.kind == 0) {
+        s.fill(op.x, op.y, op.w, op.h, op.color);
+    } else if (op.kind == 1) {
+        static uint16_t buf[LcdDma::BUFFER_PIXELS];
+        pattern(buf, op.w * op.h, op.seed);
+        s.blit(op.x, op.y, op.w, op.h, buf);
+    } else {
+        s.blit(op.x, op.y, op.w, op.h, pool + op.seed % (LcdDma::BUFFER_PIXELS - op.w * op.h + 1));
+    }
+}
+
+// ------------------------- LcdDma -------------------------
+void checkLcdDma() {
+    std::mt19937 rng(1);
+    tft.fillScreen(0x5555);
+    ref.clear(0x5555);
+    tft.setSwapBytes(true);
+
+    lcdDma.beginBatch();
+    const uint16_t* first = lcdDma.buffer();
+    Op op = { 1, 0, 0, 8, 8, 0, 7 };
+    draw(lcdDma, op);
+    drawRef(ref, op);
+    check(lcdDma.buffer() != first, "lcd_dma: push switches to the other buffer");
+    for (int i = 0; i < 500; i++) {
+        op = randomOp(rng);
+        draw(lcdDma, op);
+        drawRef(ref, op);
+    }
+    lcdDma.endBatch();
+    check(tft.getSwapBytes(), "lcd_dma: endBatch restores swapBytes");
+    checkPanel(tft, "lcd_dma: push / pushPixels / fill");
+
+    // キャプチャ中はパネルに送らず、面に書く（画面外は切り捨て）
+    static Surface expect;
+    std::vector<uint16_t> frame(W * H, LcdDma::swap(0x0F0F));
+    expect.clear(0x0F0F);
+    const long windows = tft.windows;
+    const long rects = tft.rects;
+    const Op edges[] = {
+        { 1, -5, -3, 16, 8, 0, 11 }, { 1, W - 6, H - 4, 16, 8, 0, 12 }, { 0, -10, H - 10, 40, 20, 0xF800, 0 },
+        { 2, W - 3, 20, 8, 8, 0, 13 }, { 0, 100, -4, 8, 8, 0x07E0, 0 },
+    };
+    lcdDma.beginBatch();
+    lcdDma.beginCapture(frame.data(), W, H);
+    for (const Op &e : edges) {
+        draw(lcdDma, e);
+        drawRef(expect, e);
+    }
+    for (int i = 0; i < 200; i++) {
+        op = randomOp(rng);
+        draw(lcdDma, op);
+        drawRef(expect, op);
+    }
+    lcdDma.endCapture();
+    lcdDma.endBatch();
+    check(tft.windows == windows && tft.rects == rects, "lcd_dma: capture sends nothing to the panel");
+    bool same = true;
+    for (int i = 0; i < W * H; i++) same = same && LcdDma::swap(frame[i]) == expect.px[i / W][i % W];
+    check(same, "lcd_dma: capture writes the clipped rectangles into the frame");
+    checkPanel(tft, "lcd_dma: panel unchanged by capture");
+
+    // DMA を初期化できないときは pushImage で同期して送る
+    static TFT_eSPI syncPanel;
+    syncPanel.dmaAvailable = false;
+    syncPanel.isDmaCapable = isDmaCapable;
+    syncPanel.fillScreen(0x5555);
+    ref.clear(0x5555);
+    LcdDma sync;
+    check(!sync.begin(syncPanel) && sync.ready(), "lcd_dma: begin without DMA still draws");
+    sync.beginBatch();
+    for (int i = 0; i < 200; i++) {
+        op = randomOp(rng);
+        draw(sync, op);
+        drawRef(ref, op);
+    }
+    sync.endBatch();
+    check(syncPanel.dmaPushes == 0, "lcd_dma: no DMA when initDMA fails");
+    checkPanel(syncPanel, "lcd_dma: synchronous push / pushPixels / fill");
+    std::printf("lcd_dma: %ld DMA pushes, %ld fillRect\n", tft.dmaPushes, tft.rects);
+}
+
+// ------------------------- FrameComposer -------------------------
+void checkCompose() {
+    std::mt19937 rng(2);
+    check(frameComposer.begin(tft), "compose: enabled");
+    tft.fillScreen(0x5555);
+    ref.clear(0);   // 面は黒で始まる
+
+    std::vector<Op> ops;
+    for (int f = 0; f < 6; f++) {
+        if (f == 0) {
+            ops.push_back({ 0, 0, 0, W, H, 0x18E3, 0 });
+            for (int i = 0; i < 150; i++) ops.push_back(randomOp(rng));
+        } else if (f == 2 || f == 4) {
+            ops.clear();
+            for (int i = 0; i < 3; i++) ops.push_back(randomOp(rng));
+        }
+        // f = 1, 3, 5 は前と同じ描画（面の内容は変わらない）
+        lcdDma.beginBatch();
+        frameComposer.beginFrame();
+        for (const Op &op : ops) {
+            draw(lcdDma, op);
+            drawRef(ref, op);
+        }
+        const FrameComposer::FrameStats st = frameComposer.endFrame();
+        lcdDma.endBatch();
+        checkPanel(tft, "compose: panel equals the directly drawn frame");
+        if (f == 0) check(st.changedBlocks == st.blocks, "compose: first frame sends every block");
+        if (f % 2 == 1) check(st.changedBlocks == 0, "compose: unchanged frame sends nothing");
+        if (f == 2 || f == 4) check(st.changedBlocks > 0 && st.changedBlocks < st.blocks, "compose: partial update");
+        std::printf("compose frame %d: %u/%u blocks, %u rects, %u bytes\n", f, st.changedBlocks, st.blocks, st.rects,
+                    st.bytesSent);
+    }
+
+    // 合成を通さずにパネルへ描いたら invalidate() で全部送り直す
+    lcdDma.beginBatch();
+    lcdDma.fill(0, 0, W, H, 0xFFFF);
+    lcdDma.endBatch();
+    frameComposer.invalidate();
+    frameComposer.beginFrame();
+    const FrameComposer::FrameStats st = frameComposer.endFrame();
+    check(st.changedBlocks == st.blocks, "compose: invalidate resends every block");
+    checkPanel(tft, "compose: panel restored after invalidate");
+}
+
+// ------------------------- RenderEngine -------------------------
+// 図鑑画面と同じように、画面全体の枠（層 0）の上に重なり合う部品（層 1）を置く
+struct Item {
+    int x, y, w, h;     // 領域の中の矩形（w = 0 なら何も描かない）
+    int kind;           // 0: fill, 1: push
+    uint16_t color;
+    uint32_t seed;
+};
+
+const int itemRect[5][4] = { { 20, 20, 112, 112 }, { 170, 18, 54, 16 }, { 170, 32, 140, 32 }, { 20, 156, 292, 76 },
+                             { 100, 100, 100, 80 } };   // 最後の 1 つは ほかの領域と重なる
+const int drawOrder[5] = { 1, 0, 2, 4, 3 };   // itemRect を (y, x) の順に並べたもの
+Item items[5];
+uint16_t frameColor = 0x1111;
+
+void drawItemTo(LcdDma &dma, Surface* s, const Item &it) {
+    if (!it.w) return;
+    // push はバッファに入る高さずつ
+    for (int y = 0; y < it.h;) {
+        int h = it.h - y;
+        if (it.w * h > (int)LcdDma::BUFFER_PIXELS) h = LcdDma::BUFFER_PIXELS / it.w;
+        Op op = { it.kind, it.x, it.y + y, it.w, h, it.color, it.seed + y };
+        if (s) drawRef(*s, op);
+        else draw(dma, op);
+        y += h;
+    }
+}
+
+void drawFrameRegion(void*) {
+    lcdDma.fill(0, 0, W, 8, frameColor);
+    lcdDma.fill(0, H - 8, W, 8, frameColor);
+    lcdDma.fill(0, 0, 8, H, frameColor);
+    lcdDma.fill(W - 8, 0, 8, H, frameColor);
+}
+
+void drawItemRegion(void* ctx) {
+    drawItemTo(lcdDma, nullptr, *static_cast<Item*>(ctx));
+}
+
+void checkRender(bool compose) {
+    const char* name = compose ? "render+compose" : "render";
+    std::mt19937 rng(3);
+    RenderEngine engine;
+    engine.addRegion("frame", 0, 0, W, H, 0, drawFrameRegion, nullptr);
+    int ids[5];
+    for (int i = 0; i < 5; i++) {
+        items[i] = Item();
+        ids[i] = engine.addRegion("item", itemRect[i][0], itemRect[i][1], itemRect[i][2], itemRect[i][3], 1,
+                                  drawItemRegion, &items[i]);
+    }
+    tft.fillScreen(0x5555);
+    if (compose) frameComposer.invalidate();
+
+    uint32_t repainted = 0;
+    const int frames = 300;
+    for (int f = 0; f < frames; f++) {
+        for (int i = 0; i < 5; i++) {
+            if (rng() % 3) continue;
+            const int* r = itemRect[i];
+            Item &it = items[i];
+            it.w = 1 + rng() % r[2];
+            it.h = 1 + rng() % r[3];
+            it.x = r[0] + rng() % (r[2] - it.w + 1);
+            it.y = r[1] + rng() % (r[3] - it.h + 1);
+            it.kind = rng() % 2;
+            it.color = rng();
+            it.seed = rng();
+        }
+        if (f % 50 == 49) frameColor = rng();
+        const uint16_t bg = f < frames / 2 ? 0xF81F : 0x0F0F;
+
+        // 毎回全部描き直した画面
+        ref.clear(bg);
+        ref.fill(0, 0, W, 8, frameColor);
+        ref.fill(0, H - 8, W, 8, frameColor);
+        ref.fill(0, 0, 8, H, frameColor);
+        ref.fill(W - 8, 0, 8, H, frameColor);
+        // 同じ層の領域は上から・左から描かれる
+        for (int i : drawOrder) drawItemTo(lcdDma, &ref, items[i]);
+
+        engine.setBackground(bg);
+        engine.setContent(0, frameColor);
+        for (int i = 0; i < 5; i++) engine.setContent(ids[i], RenderEngine::hash(&items[i], sizeof(Item)));
+        if (compose) frameComposer.beginFrame();
+        repainted += engine.render().repainted;
+        if (compose) frameComposer.endFrame();
+        if (!panelIs(tft, ref)) {
+            std::printf("NG: %s: frame %d differs from a full redraw\n", name, f);
+            failures++;
+            return;
+        }
+        checkPanel(tft, name);
+    }
+    std::printf("%s: %d frames, %.1f regions repainted per frame\n", name, frames, double(repainted) / frames);
+}
+
+// ------------------------- 8x8 フォント -------------------------
+void glyphRef(Surface &s, int x, int y, const uint8_t* buf, uint16_t color, uint16_t bg, int scale) {
+    for (int row = 0; row < 8; row++) {
+        for (int col = 0; col < 8; col++) {
+            s.fill(x + col * scale, y + row * scale, scale, scale, (buf[row] >> (7 - col)) & 1 ? color : bg);
+        }
+    }
+}
+
+void checkGlyph() {
+    std::mt19937 rng(5);
+    uint8_t glyph[8];
+    for (uint8_t &b : glyph) b = rng();
+    tft.fillScreen(0x5555);
+    ref.clear(0x5555);
+    for (int scale = 1; scale <= 17; scale++) {
+        const int x = scale * 13 % 200 - 8;   // 左端からはみ出すものも混ぜる
+        const int y = scale * 29 % 120;
+        drawFont8x8(tft, x, y, glyph, 0x001F, 0xFFE0, scale);
+        // 1 行も 1 面に入らない倍率は描かない
+        if (8 * scale * scale <= (int)LcdDma::BUFFER_PIXELS) glyphRef(ref, x, y, glyph, 0x001F, 0xFFE0, scale);
+        checkPanel(tft, "glyph: drawFont8x8");
+    }
+
+    // 合成中はオフスクリーン面に描く
+    std::vector<uint16_t> frame(W * H, 0);
+    static Surface expect;
+    expect.clear(0);
+    lcdDma.beginBatch();
+    lcdDma.beginCapture(frame.data(), W, H);
+    for (int scale = 1; scale <= 17; scale++) {
+        const int x = W - scale * 37 % 250;
+        const int y = H - scale * 11 % 200;   // 右下にはみ出すものも混ぜる
+        drawFont8x8(tft, x, y, glyph, 0xF800, 0x07E0, scale);
+        if (8 * scale * scale <= (int)LcdDma::BUFFER_PIXELS) glyphRef(expect, x, y, glyph, 0xF800, 0x07E0, scale);
+    }
+    lcdDma.endCapture();
+    lcdDma.endBatch();
+    bool same = true;
+    for (int i = 0; i < W * H; i++) same = same && LcdDma::swap(frame[i]) == expect.px[i / W][i % W];
+    check(same, "glyph: drawFont8x8 into the captured frame");
+    checkPanel(tft, "glyph: panel unchanged by capture");
+}
+
+// ------------------------- 図鑑画面の配置 -------------------------
+// main.cpp の描画関数と同じ並べ方で描く。文字の形はコードから作り、奇数のコードには上文字を付ける
+struct DexContent {
+    std::vector<uint8_t> number, name, type, height, weight, text;
+    uint8_t spriteSeed;
+};
+DexContent dex;
+
+void glyphFor(uint8_t code, uint8_t out[8]) {
+    for (int i = 0; i < 8; i++) out[i] = static_cast<uint8_t>(code * 37 + i * 101);
+}
+
+// drawBinaryString + drawKanaStacked と同じ。戻り値は次の文字を置く x
+int drawDexString(const std::vector<uint8_t> &codes, const TextBox &box) {
+    TextCursor cursor(box);
+    uint8_t glyph[8];
+    lcdDma.beginBatch();
+    for (size_t i = 0; i < codes.size() && !cursor.full(); i++) {
+        int x, y;
+        if (!cursor.place(codes[i], x, y)) continue;
+        glyphFor(codes[i], glyph);
+        if (box.accents && (codes[i] & 1)) drawFont8x8(tft, x, y, glyph, 0x0000, 0xFFDF, box.scale);
+        glyph[0] ^= 0xFF;
+        drawFont8x8(tft, x, y + 8 * box.scale, glyph, 0x0000, 0xFFDF, box.scale);
+    }
+    lcdDma.endBatch();
+    return cursor.x();
+}
+
+// 単位のタイル（ベース文字の段）
+void drawUnitTiles(const TextBox &box, int penX, int tiles) {
+    for (int i = 0; i < tiles; i++) lcdDma.fill(unitX(box, penX) + i * 8, box.y + 8 * box.scale, 8, 8, 0x7BEF);
+}
+
+void drawDexFrame(void*) { drawMap(); }
+void drawDexNumber(void*) { drawDexString(dex.number, numberText); }
+void drawDexName(void*) { drawDexString(dex.name, nameText); }
+void drawDexSprite(void*) {
+    const DexRect r = spriteRect();
+    const int size = (5 + dex.spriteSeed % 3) * 8 * SPRITE_SCALE;   // 40x40 / 48x48 / 56x56
+    lcdDma.fill(r.x, r.y, size, size, 0x0400 + dex.spriteSeed);
+}
+void drawDexType(void*) {
+    static const std::vector<uint8_t> suffix = { 0x81, 0x82, 0x83, 0x84 };
+    drawDexString(suffix, typeSuffixBox(drawDexString(dex.type, typeText)));
+}
+void drawDexHeight(void*) { drawUnitTiles(heightText, drawDexString(dex.height, heightText), 1); }
+void drawDexWeight(void*) { drawUnitTiles(weightText, drawDexString(dex.weight, weightText), 2); }
+void drawDexText(void*) { drawDexString(dex.text, dexText); }
+
+struct DexRegion {
+    const char* name;
+    DexRect rect;
+    RenderEngine::DrawFn draw;
+};
+
+// codes: 0x80 以降の文字、ときどき空白と改行
+std::vector<uint8_t> randomCodes(std::mt19937 &rng, int maxLength, bool breaks) {
+    std::vector<uint8_t> codes(rng() % (maxLength + 1));
+    for (uint8_t &c : codes) {
+        const int r = rng() % 16;
+        c = r == 0 ? 0x7F : breaks && r == 1 ? 0x4E : breaks && r == 2 ? 0x4F : 0x80 + rng() % 0x80;
+    }
+    return codes;
+}
+
+void randomDex(std::mt19937 &rng) {
+    dex.number = randomCodes(rng, 5, false);
+    dex.name = randomCodes(rng, 12, false);
+    dex.type = randomCodes(rng, 8, false);
+    dex.height = randomCodes(rng, 6, false);
+    dex.weight = randomCodes(rng, 7, false);
+    dex.text = randomCodes(rng, 200, true);
+    dex.spriteSeed = rng();
+}
+
+void checkDexLayout() {
+    std::mt19937 rng(6);
+    const DexRegion regions[] = {
+        { "number", numberRect(), drawDexNumber }, { "name", nameRect(), drawDexName },
+        { "sprite", spriteRect(), drawDexSprite }, { "type", typeRect(), drawDexType },
+        { "height", heightRect(), drawDexHeight }, { "weight", weightRect(), drawDexWeight },
+        { "text", dexTextRect(), drawDexText },
+    };
+
+    // 領域の矩形はマップの枠のタイルに重ならない（領域を塗り直すと、下の層の枠は描き直されないので消える）
+    for (const DexRegion &r : regions) {
+        bool clear = r.rect.x >= 0 && r.rect.y >= 0 && r.rect.x + r.rect.w <= W && r.rect.y + r.rect.h <= H;
+        for (int my = r.rect.y / 8; clear && my < (r.rect.y + r.rect.h + 7) / 8; my++) {
+            for (int mx = r.rect.x / 8; mx < (r.rect.x + r.rect.w + 7) / 8; mx++) clear = clear && mapData[my][mx] == 0;
+        }
+        if (!clear) std::printf("NG: dex: region %s overlaps the map frame\n", r.name);
+        failures += !clear;
+    }
+
+    // 描画関数はどんな内容でも領域の矩形の外を描かない
+    int outside = 0;
+    for (int round = 0; round < 300; round++) {
+        randomDex(rng);
+        if (round == 0) {
+            // 枠いっぱいより長い、改行の無い文字列
+            dex.number.assign(9, 0x90);
+            dex.name.assign(20, 0x91);
+            dex.type.assign(20, 0x93);
+            dex.height.assign(9, 0x95);
+            dex.weight.assign(9, 0x97);
+            dex.text.assign(400, 0x99);
+        }
+        for (const DexRegion &r : regions) {
+            if (r.draw == drawDexSprite) dex.spriteSeed = 2;   // 一番大きい 56x56
+            tft.fillScreen(0x5555);
+            r.draw(nullptr);
+            for (int y = 0; y < H; y++) {
+                for (int x = 0; x < W; x++) {
+                    const bool inside = x >= r.rect.x && x < r.rect.x + r.rect.w && y >= r.rect.y && y < r.rect.y + r.rect.h;
+                    if (!inside && tft.fb[y][x] != 0x5555 && outside++ == 0) {
+                        std::printf("NG: dex: %s draws (%d, %d) outside (%d, %d, %d, %d)\n", r.name, x, y, r.rect.x,
+                                    r.rect.y, r.rect.w, r.rect.h);
+                    }
+                }
+            }
+        }
+    }
+    failures += outside > 0;
+    checkViolations(tft, "dex: draw functions");
+
+    // 内容を差し替えながら、差分描画が毎回全部描き直した画面と同じこと
+    RenderEngine engine;
+    int ids[8];
+    ids[0] = engine.addRegion("frame", 0, 0, MAP_W * 8, MAP_H * 8, 0, drawDexFrame, nullptr);
+    for (int i = 0; i < 7; i++) {
+        const DexRect &r = regions[i].rect;
+        ids[i + 1] = engine.addRegion(regions[i].name, r.x, r.y, r.w, r.h, 1, regions[i].draw, nullptr);
+    }
+    engine.setBackground(0xFFDF);
+    tft.fillScreen(0x5555);
+    static uint16_t shown[H][W];
+    uint32_t repainted = 0;
+    const int frames = 300;
+    for (int f = 0; f < frames; f++) {
+        const DexContent before = dex;
+        randomDex(rng);
+        // 1 画面で変わるのは一部の領域だけのことが多い
+        if (rng() % 2) dex.number = before.number;
+        if (rng() % 2) dex.name = before.name;
+        if (rng() % 2) dex.type = before.type;
+        if (rng() % 2) dex.text = before.text;
+        if (rng() % 2) dex.spriteSeed = before.spriteSeed;
+        engine.setContent(ids[0], RenderEngine::hash(mapData, sizeof(mapData)));
+        engine.setContent(ids[1], RenderEngine::hash(dex.number.data(), dex.number.size()));
+        engine.setContent(ids[2], RenderEngine::hash(dex.name.data(), dex.name.size()));
+        engine.setContent(ids[3], RenderEngine::hash(&dex.spriteSeed, 1));
+        engine.setContent(ids[4], RenderEngine::hash(dex.type.data(), dex.type.size()));
+        engine.setContent(ids[5], RenderEngine::hash(dex.height.data(), dex.height.size()));
+        engine.setContent(ids[6], RenderEngine::hash(dex.weight.data(), dex.weight.size()));
+        engine.setContent(ids[7], RenderEngine::hash(dex.text.data(), dex.text.size()));
+        repainted += engine.render().repainted;
+        std::memcpy(shown, tft.fb, sizeof(shown));
+
+        // 全部描き直す（領域と同じく、層ごとに上から・左から）
+        tft.fillScreen(0xFFDF);
+        drawMap();
+        drawDexNumber(nullptr);
+        drawDexSprite(nullptr);
+        drawDexName(nullptr);
+        drawDexType(nullptr);
+        drawDexHeight(nullptr);
+        drawDexWeight(nullptr);
+        drawDexText(nullptr);
+        if (std::memcmp(shown, tft.fb, sizeof(shown)) != 0) {
+            std::printf("NG: dex: frame %d differs from a full redraw\n", f);
+            failures++;
+            break;
+        }
+        std::memcpy(tft.fb, shown, sizeof(shown));
+    }
+    checkViolations(tft, "dex: render");
+    std::printf("dex: %d frames, %.1f regions repainted per frame\n", frames, double(repainted) / frames);
+}
+
+// ------------------------- マップ -------------------------
+uint8_t tiles[17][16];
+
+// 1 タイルずつ描いた画面（タイル 0 と tileset の外は描かない）
+void mapRef() {
+    uint16_t buf[64];
+    for (int my = 0; my < MAP_H; my++) {
+        for (int mx = 0; mx < MAP_W; mx++) {
+            uint8_t t = mapData[my][mx];
+            if (t == 0 || t >= tileset.size()) continue;
+            decodeTile2bpp(tileset[t], buf);
+            for (int i = 0; i < 64; i++) ref.px[my * 8 + i / 8][mx * 8 + i % 8] = buf[i];
+        }
+    }
+}
+
+void checkMap() {
+    std::mt19937 rng(4);
+    static uint8_t defaultMap[MAP_H][MAP_W];
+    std::memcpy(defaultMap, mapData, sizeof(mapData));
+    for (auto &t : tiles) {
+        for (auto &b : t) b = rng();
+    }
+    std::memset(tiles[4], 0xFF, 16);    // 無地
+    std::memset(tiles[15], 0x00, 16);   // 無地
+    std::memset(tiles[9], 0x55, 16);    // 縞
+    tileset.clear();
+    for (int i = 0; i < 16; i++) tileset.push_back(tiles[i]);
+    invalidateTileCache();
+
+    for (int pass = 0; pass < 5; pass++) {
+        const char* what = "map: default map";
+        if (pass == 1) {
+            gb_palette[3] = 0xF00F;
+            what = "map: palette change";
+        } else if (pass == 2) {
+            for (auto &row : mapData) {
+                for (auto &c : row) c = rng() % 3 == 0 ? 0 : rng() % 18;   // 16, 17 は tileset の外
+            }
+            what = "map: random map";
+        } else if (pass == 3) {
+            // タイル数が変わるとキャッシュを確保し直す。DMA で読めるメモリが無ければ普通のメモリに置く
+            refuseDma = true;
+            tileset.push_back(tiles[16]);
+            what = "map: tile cache not DMA-capable";
+        } else if (pass == 4) {
+            std::memset(tiles[16], 0xAA, 16);
+            invalidateTileCache();
+            what = "map: invalidateTileCache";
+        }
+        ref.clear(0x5555);
+        mapRef();
+
+        tft.fillScreen(0x5555);
+        tft.windows = 0;
+        tft.rects = 0;
+        drawMap();
+        checkPanel(tft, what);
+        const long spanWindows = tft.windows + tft.rects;
+
+        tft.fillScreen(0x5555);
+        tft.windows = 0;
+        tft.rects = 0;
+        lcdDma.beginBatch();
+        for (int my = 0; my < MAP_H; my++) {
+            for (int mx = 0; mx < MAP_W; mx++) {
+                if (mapData[my][mx]) drawTileAt(mx * 8, my * 8, mapData[my][mx]);
+            }
+        }
+        lcdDma.endBatch();
+        checkPanel(tft, "map: drawTileAt");
+        std::printf("%s: spans %ld transfers, per tile %ld\n", what, spanWindows, tft.windows + tft.rects);
+        check(spanWindows <= tft.windows + tft.rects, "map: spans use no more transfers than tiles");
+    }
+    refuseDma = false;
+    std::memcpy(mapData, defaultMap, sizeof(mapData));
+}
+
+}  // namespace
+
+int main() {
+    tft.isDmaCapable = isDmaCapable;
+    pattern(pool, LcdDma::BUFFER_PIXELS, 99);
+    dmaBlocks.push_back({ reinterpret_cast<const uint8_t*>(pool), sizeof(pool) });
+    if (!lcdDma.begin(tft)) {
+        std::printf("NG: LcdDma::begin\n");
+        return 1;
+    }
+    checkLcdDma();
+    checkCompose();
+    checkRender(false);
+    checkRender(true);
+    checkGlyph();
+    checkMap();
+    checkDexLayout();
+    std::printf(failures ? "%d checks failed\n" : "all render checks passed\n", failures);
+    return failures ? 1 : 0;
+}
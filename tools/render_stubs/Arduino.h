@@ -0,0 +1,6 @@
+// render_check 用の Arduino.h の代わり（描画コードが使う分だけ）
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+unsigned long micros();
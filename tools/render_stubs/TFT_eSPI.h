@@ -0,0 +1,123 @@
+// render_check 用の TFT_eSPI の代わり: 描いた画素を fb に残し、転送の回数を数える
+//
+// fb には論理色（RGB565）で残す。pushImage / pushImageDMA は swapBytes が false なら
+// バッファの画素をパネルに送る順（バイトスワップ済み）として読む（本物と同じ）。
+// DMA 転送は dmaWait() か次の SPI 操作まで終わらないことにして、次のことを違反として数える。
+//   - DMA 転送中にほかの描画（fillRect / pushImage / 次の転送以外）をした
+//   - DMA 転送が終わる前に送り元のバッファを書き換えた
+//   - swapBytes が true のまま pushImageDMA した（本物はバッファをその場でスワップする）
+//   - DMA で読めないメモリから pushImageDMA した（isDmaCapable を設定したとき）
+//   - startWrite() の外で pushImageDMA した、endWrite() を DMA 転送中に呼んだ
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+
+class TFT_eSPI {
+public:
+    static constexpr int WIDTH = 320;
+    static constexpr int HEIGHT = 240;
+
+    uint16_t fb[HEIGHT][WIDTH];
+    long windows = 0;      // 送った矩形の数（fillRect を除く）
+    long rects = 0;        // fillRect の数
+    long dmaPushes = 0;
+    long violations = 0;
+    const char* lastViolation = "";
+    bool dmaAvailable = true;
+    // pushImageDMA の送り元が DMA で読めるメモリか（nullptr なら調べない）
+    bool (*isDmaCapable)(const void* data, size_t bytes) = nullptr;
+
+    int16_t width() const { return WIDTH; }
+    int16_t height() const { return HEIGHT; }
+    void setSwapBytes(bool swap) { swap_ = swap; }
+    bool getSwapBytes() const { return swap_; }
+    bool initDMA(bool = false) { return dmaAvailable; }
+
+    void startWrite() { writeDepth_++; }
+    void endWrite() {
+        if (busy_) violate("endWrite during DMA");
+        if (writeDepth_ > 0) writeDepth_--;
+    }
+
+    bool dmaBusy() const { return busy_; }
+    void dmaWait() { complete(); }
+
+    void pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* data, uint16_t* = nullptr) {
+        complete();  // 本物も前の転送の完了を待ってから始める
+        check();
+        if (swap_) violate("pushImageDMA with swapBytes");
+        if (isDmaCapable && !isDmaCapable(data, w * h * sizeof(uint16_t))) violate("DMA from non-DMA memory");
+        pending_.assign(data, data + w * h);
+        pendingSrc_ = data;
+        px_ = x; py_ = y; pw_ = w; ph_ = h;
+        busy_ = true;
+        dmaPushes++;
+        windows++;
+    }
+    void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* data) {
+        idle();
+        windows++;
+        blit(x, y, w, h, data, swap_);
+    }
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+        idle();
+        rects++;
+        for (int32_t j = y; j < y + h; j++) {
+            for (int32_t i = x; i < x + w; i++) {
+                if (j >= 0 && j < HEIGHT && i >= 0 && i < WIDTH) fb[j][i] = static_cast<uint16_t>(color);
+            }
+        }
+    }
+    void drawPixel(int32_t x, int32_t y, uint32_t color) { fillRect(x, y, 1, 1, color); }
+    void fillScreen(uint32_t color) {
+        for (auto &row : fb) {
+            for (auto &p : row) p = static_cast<uint16_t>(color);
+        }
+    }
+
+private:
+    static uint16_t swap16(uint16_t v) { return static_cast<uint16_t>((v << 8) | (v >> 8)); }
+
+    void violate(const char* what) {
+        violations++;
+        lastViolation = what;
+    }
+    void check() {
+        if (writeDepth_ == 0) violate("DMA outside startWrite");
+    }
+    // DMA 以外の SPI 操作の前
+    void idle() {
+        if (busy_) {
+            violate("SPI use during DMA");
+            complete();
+        }
+    }
+    // DMA 転送を終える（送り元が転送中に変わっていないか確かめてから fb に書く）
+    void complete() {
+        if (!busy_) return;
+        busy_ = false;
+        if (memcmp(pendingSrc_, pending_.data(), pending_.size() * sizeof(uint16_t)) != 0) {
+            violate("DMA source modified in flight");
+        }
+        blit(px_, py_, pw_, ph_, pending_.data(), false);
+    }
+    void blit(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* data, bool swapBytes) {
+        for (int32_t j = 0; j < h; j++) {
+            for (int32_t i = 0; i < w; i++) {
+                uint16_t v = data[j * w + i];
+                if (y + j >= 0 && y + j < HEIGHT && x + i >= 0 && x + i < WIDTH) {
+                    fb[y + j][x + i] = swapBytes ? v : swap16(v);
+                }
+            }
+        }
+    }
+
+    bool swap_ = false;
+    int writeDepth_ = 0;
+    bool busy_ = false;
+    std::vector<uint16_t> pending_;
+    const uint16_t* pendingSrc_ = nullptr;
+    int32_t px_ = 0, py_ = 0, pw_ = 0, ph_ = 0;
+};
@@ -0,0 +1,13 @@
+// render_check 用の esp_heap_caps.h の代わり。確保は render_check.cpp で行い、
+// DMA 用の確保をわざと失敗させられるようにする
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+void* heap_caps_malloc(size_t size, uint32_t caps);
+void heap_caps_free(void* ptr);
@@ -0,0 +1,99 @@
+// ROM を圧縮コンテナ(.rpk)に変換するホスト用ツール
+//
+//   g++ -std=c++17 -O2 -I../src rom_pack.cpp ../src/data/rom_pack.cpp ../src/data/rom_lz.cpp -o rom_pack
+//   ./rom_pack pokemon_blue.gb pokemon_blue.rpk [blockShift=12]
+//
+// 圧縮率と、ブロック展開を挟んだ読み出しの遅延（図鑑画面と同程度の小さな読み出し）を表示する。
+// 実機での1画面あたりの時間は Serial の 'b' コマンドで測る。
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "data/rom_pack.h"
+
+static bool readAll(const char* path, std::vector<uint8_t> &out) {
+    FILE* f = std::fopen(path, "rb");
+    if (!f) return false;
+    std::fseek(f, 0, SEEK_END);
+    out.resize(std::ftell(f));
+    std::fseek(f, 0, SEEK_SET);
+    bool ok = std::fread(out.data(), 1, out.size(), f) == out.size();
+    std::fclose(f);
+    return ok;
+}
+
+static double microsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: %s <rom.gb> <out.rpk> [blockShift=12]\n", argv[0]);
+        return 1;
+    }
+    int blockShift = argc > 3 ? std::atoi(argv[3]) : 12;
+
+    std::vector<uint8_t> rom;
+    if (!readAll(argv[1], rom)) {
+        std::fprintf(stderr, "cannot read %s\n", argv[1]);
+        return 1;
+    }
+    std::vector<uint8_t> packed;
+    if (!packRom(rom.data(), rom.size(), static_cast<uint8_t>(blockShift), packed)) {
+        std::fprintf(stderr, "pack failed\n");
+        return 1;
+    }
+    FILE* f = std::fopen(argv[2], "wb");
+    if (!f || std::fwrite(packed.data(), 1, packed.size(), f) != packed.size()) {
+        std::fprintf(stderr, "cannot write %s\n", argv[2]);
+        return 1;
+    }
+    std::fclose(f);
+    std::printf("%s: %zu -> %zu bytes (%.1f%%), block %d bytes\n",
+                argv[1], rom.size(), packed.size(), 100.0 * packed.size() / rom.size(), 1 << blockShift);
+
+    // 全体を読み戻して一致を確認
+    PackedRomReader reader;
+    if (!reader.open(argv[2])) {
+        std::fprintf(stderr, "cannot open packed file\n");
+        return 1;
+    }
+    std::vector<uint8_t> back(rom.size());
+    if (reader.read(0, back.data(), back.size()) != rom.size() || back != rom) {
+        std::fprintf(stderr, "verify failed\n");
+        return 1;
+    }
+    std::printf("verify: OK\n");
+
+    // 図鑑画面の読み出しに近い 5～700 バイトのランダム読み出しで遅延を比べる
+    const int reads = 20000;
+    std::mt19937 rng(1);
+    std::vector<uint32_t> offs(reads), lens(reads);
+    for (int i = 0; i < reads; i++) {
+        lens[i] = 5 + rng() % 700;
+        offs[i] = rng() % (rom.size() - lens[i]);
+    }
+    std::vector<uint8_t> buf(1024);
+
+    FILE* raw = std::fopen(argv[1], "rb");
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < reads; i++) {
+        std::fseek(raw, offs[i], SEEK_SET);
+        if (std::fread(buf.data(), 1, lens[i], raw) != lens[i]) return 1;
+    }
+    double rawUs = microsSince(t0);
+    std::fclose(raw);
+
+    reader.resetStats();
+    t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < reads; i++) {
+        if (reader.read(offs[i], buf.data(), lens[i]) != lens[i]) return 1;
+    }
+    double packedUs = microsSince(t0);
+    const PackedRomReader::Stats &st = reader.stats();
+    std::printf("random reads: raw %.2f us/read, packed %.2f us/read (blocks hit=%u miss=%u, %.2f us/block decompress)\n",
+                rawUs / reads, packedUs / reads, st.blockHits, st.blockMisses,
+                st.blockMisses ? double(st.decompressMicros) / st.blockMisses : 0.0);
+    return 0;
+}